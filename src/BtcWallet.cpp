@@ -92,14 +92,15 @@ BtcWallet::BtcWallet(const std::string &fileData, const QString &password) {
     const std::string wifEncrypted = pair.first;
     address = pair.second;
 
-    wif = decryptWif(wifEncrypted, password);
+    const std::string decryptedWif = decryptWif(wifEncrypted, password);
+    wif = toSecureBytes(decryptedWif);
 
     if (address.empty()) {
         bool tmp;
-        address = ::getAddress(wif, tmp, false);
+        address = ::getAddress(decryptedWif, tmp, false);
     } else {
         bool tmp;
-        const std::string calcAddress = ::getAddress(wif, tmp, false);
+        const std::string calcAddress = ::getAddress(decryptedWif, tmp, false);
         CHECK_TYPED(calcAddress == address, TypeErrors::PRIVATE_KEY_ERROR, "Incorrect encrypted wif: address calc incorrect");
     }
 }
@@ -109,11 +110,22 @@ BtcWallet::BtcWallet(const QString &folder, const std::string &address_, const Q
 {}
 
 BtcWallet::BtcWallet(const std::string &decryptedWif)
-    : wif(decryptedWif)
+    : wif(toSecureBytes(decryptedWif))
 {
     CHECK_TYPED(decryptedWif.substr(0, 2) != "6P", TypeErrors::PRIVATE_KEY_ERROR, "Incorrect encrypted wif " + decryptedWif);
 }
 
+BtcWallet::BtcWallet(const std::string &address, const SecureBytes &decryptedWif)
+    : wif(decryptedWif)
+    , address(address)
+{
+    CHECK_TYPED(wif.size() < 2 || wif[0] != '6' || wif[1] != 'P', TypeErrors::PRIVATE_KEY_ERROR, "Incorrect encrypted wif");
+}
+
+SecureBytes BtcWallet::getDecryptedWif() const {
+    return wif;
+}
+
 const std::string& BtcWallet::getAddress() const {
     return address;
 }
@@ -121,19 +133,33 @@ const std::string& BtcWallet::getAddress() const {
 std::string BtcWallet::genTransaction(const std::vector<BtcInput> &inputs, uint64_t transferAmount, uint64_t fee, const std::string &receiveAddress, bool isTestnet) {
     checkAddressBase56(receiveAddress);
 
+    // btctx принимает ключ только строкой, поэтому копии живут лишь на время подписи и затираются после нее
     std::vector<Input> inputs2;
-    for (const BtcInput &input: inputs) {
-        Input input2;
-        input2.wif = wif;
-        input2.outBalance = input.outBalance;
-        input2.scriptPubkey = HexStringToDump(input.scriptPubkey);
-        input2.spendoutnum = input.spendoutnum;
-        input2.spendtxid = HexStringToDump(input.spendtxid);
-
-        inputs2.push_back(input2);
-    }
+    const auto wipeInputs = [&inputs2]{
+        for (Input &input2: inputs2) {
+            secureZero(&input2.wif[0], input2.wif.size());
+        }
+    };
+    inputs2.reserve(inputs.size());
+    std::string tx;
+    try {
+        for (const BtcInput &input: inputs) {
+            Input input2;
+            input2.wif.assign(wif.begin(), wif.end());
+            input2.outBalance = input.outBalance;
+            input2.scriptPubkey = HexStringToDump(input.scriptPubkey);
+            input2.spendoutnum = input.spendoutnum;
+            input2.spendtxid = HexStringToDump(input.spendtxid);
+
+            inputs2.emplace_back(std::move(input2));
+        }
 
-    const std::string tx = BuildBTCTransaction(inputs2, fee, transferAmount, receiveAddress, isTestnet);
+        tx = BuildBTCTransaction(inputs2, fee, transferAmount, receiveAddress, isTestnet);
+    } catch (...) {
+        wipeInputs();
+        throw;
+    }
+    wipeInputs();
     return DumpToHexString(tx);
 }
 
@@ -300,14 +326,22 @@ std::vector<std::pair<QString, QString>> BtcWallet::getAllWalletsInFolder(const
     const QDir dir(folder);
     const QStringList allFiles = dir.entryList(QDir::NoDotAndDotDot | QDir::System | QDir::Hidden  | QDir::AllDirs | QDir::Files, QDir::DirsFirst);
     for (const QString &file: allFiles) {
-        const std::string address = getWifAndAddress(folder, file.toStdString(), true).second;
-        CHECK_TYPED(!address.empty(), TypeErrors::INCORRECT_ADDRESS_OR_PUBLIC_KEY, "empty result");
-        result.emplace_back(QString::fromStdString(address), getFullPath(folder, address));
+        std::pair<QString, QString> wallet;
+        if (parseWalletFile(folder, file, wallet)) {
+            result.emplace_back(wallet);
+        }
     }
 
     return result;
 }
 
+bool BtcWallet::parseWalletFile(const QString &folder, const QString &file, std::pair<QString, QString> &wallet) {
+    const std::string address = getWifAndAddress(folder, file.toStdString(), true).second;
+    CHECK_TYPED(!address.empty(), TypeErrors::INCORRECT_ADDRESS_OR_PUBLIC_KEY, "empty result");
+    wallet = std::make_pair(QString::fromStdString(address), getFullPath(folder, address));
+    return true;
+}
+
 std::string BtcWallet::getOneKey(const QString &folder, const std::string &address) {
     const QString filePath = getFullPath(folder, address);
     return PREFIX_ONE_KEY + readFile(filePath);
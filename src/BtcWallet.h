@@ -7,6 +7,8 @@
 
 #include <QString>
 
+#include "SecureMemory.h"
+
 struct BtcInput {
     std::string spendtxid;
     uint32_t spendoutnum;
@@ -40,6 +42,11 @@ public:
 
     BtcWallet(const std::string &decryptedWif);
 
+    // Ключ из сессии (KeySessions), без чтения файла и BIP38
+    BtcWallet(const std::string &address, const SecureBytes &decryptedWif);
+
+    SecureBytes getDecryptedWif() const;
+
     std::string genTransaction(const std::vector<BtcInput> &inputs, uint64_t transferAmount, uint64_t fee, const std::string &receiveAddress, bool isTestnet);
 
     static std::vector<BtcInput> reduceInputs(const std::vector<BtcInput> &inputs, const std::set<std::string> &usedTxs);
@@ -56,6 +63,9 @@ public:
 
     static std::vector<std::pair<QString, QString>> getAllWalletsInFolder(const QString &folder);
 
+    // Разбирает один файл папки кошельков. false, если файл не кошелек
+    static bool parseWalletFile(const QString &folder, const QString &file, std::pair<QString, QString> &wallet);
+
     const std::string& getAddress() const;
 
     static std::string getOneKey(const QString &folder, const std::string &address);
@@ -76,7 +86,8 @@ private:
         const std::vector<BtcInput> &utxos
     );
 
-    std::string wif;
+    // Расшифрованный ключ держится только в защищенной памяти
+    SecureBytes wif;
 
     std::string address;
 };
@@ -0,0 +1,596 @@
+#include "Codecs.h"
+
+#include <atomic>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CODECS_X86
+#endif
+
+#ifdef CODECS_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSSE3
+#define TARGET_AVX2
+#endif
+
+namespace {
+
+const char HEX_CHARS[] = "0123456789abcdef";
+
+const char BASE64_CHARS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+const unsigned char INVALID = 0xFF;
+
+struct DecodeTables {
+    unsigned char hex[256];
+    unsigned char base64[256];
+
+    DecodeTables() {
+        for (size_t i = 0; i < 256; i++) {
+            hex[i] = INVALID;
+            base64[i] = INVALID;
+        }
+        for (unsigned char i = 0; i < 16; i++) {
+            hex[static_cast<unsigned char>(HEX_CHARS[i])] = i;
+        }
+        for (unsigned char i = 10; i < 16; i++) {
+            hex['A' + i - 10] = i;
+        }
+        for (unsigned char i = 0; i < 64; i++) {
+            base64[static_cast<unsigned char>(BASE64_CHARS[i])] = i;
+        }
+    }
+};
+
+const DecodeTables& decodeTables() {
+    static const DecodeTables tables;
+    return tables;
+}
+
+// Векторная часть обрабатывает сколько может и возвращает число прочитанных входных байт, остальное дорабатывает скалярный код.
+// При невалидном блоке декодер просто останавливается перед ним, ошибку найдет скалярный проход
+using BulkFunction = size_t(*)(const unsigned char *in, size_t size, unsigned char *out);
+
+size_t bulkNone(const unsigned char */*in*/, size_t /*size*/, unsigned char */*out*/) {
+    return 0;
+}
+
+struct Kernel {
+    BulkFunction encodeHex = bulkNone;
+    BulkFunction decodeHex = bulkNone;
+    BulkFunction encodeBase64 = bulkNone;
+    BulkFunction decodeBase64 = bulkNone;
+};
+
+#ifdef CODECS_X86
+
+////////////
+/// CPU ///
+////////////
+
+struct CpuFeatures {
+    bool ssse3 = false;
+    bool avx2 = false;
+};
+
+void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4]) {
+#ifdef _MSC_VER
+    int r[4];
+    __cpuidex(r, (int)leaf, (int)subleaf);
+    for (int i = 0; i < 4; i++) {
+        regs[i] = (uint32_t)r[i];
+    }
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+uint64_t xgetbv0() {
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    uint32_t eax, edx;
+    __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((uint64_t)edx << 32) | eax;
+#endif
+}
+
+CpuFeatures detectCpu() {
+    CpuFeatures features;
+    uint32_t regs[4];
+    cpuid(0, 0, regs);
+    const uint32_t maxLeaf = regs[0];
+    if (maxLeaf < 1) {
+        return features;
+    }
+    cpuid(1, 0, regs);
+    features.ssse3 = (regs[2] & (1u << 9)) != 0;
+    const bool osxsave = (regs[2] & (1u << 27)) != 0;
+    const bool avx = (regs[2] & (1u << 28)) != 0;
+    // ОС должна сохранять ymm регистры при переключении контекста
+    const bool ymmEnabled = osxsave && avx && (xgetbv0() & 0x6) == 0x6;
+    if (maxLeaf >= 7 && ymmEnabled) {
+        cpuid(7, 0, regs);
+        features.avx2 = features.ssse3 && (regs[1] & (1u << 5)) != 0;
+    }
+    return features;
+}
+
+const CpuFeatures& cpuFeatures() {
+    static const CpuFeatures features = detectCpu();
+    return features;
+}
+
+/////////////
+/// SSSE3 ///
+/////////////
+
+TARGET_SSSE3 size_t encodeHexSsse3(const unsigned char *in, size_t size, unsigned char *out) {
+    const __m128i lut = _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+    const __m128i mask = _mm_set1_epi8(0x0f);
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        const __m128i hi = _mm_shuffle_epi8(lut, _mm_and_si128(_mm_srli_epi16(v, 4), mask));
+        const __m128i lo = _mm_shuffle_epi8(lut, _mm_and_si128(v, mask));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+    return i;
+}
+
+// Значения тетрад для 16 символов. false, если есть символ не из hex
+TARGET_SSSE3 inline bool hexValuesSsse3(__m128i c, __m128i &values) {
+    const __m128i digit = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+    const __m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+    const __m128i alpha = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    const __m128i isAlpha = _mm_cmpeq_epi8(_mm_min_epu8(alpha, _mm_set1_epi8(5)), alpha);
+    values = _mm_or_si128(_mm_and_si128(isDigit, digit), _mm_and_si128(isAlpha, _mm_add_epi8(alpha, _mm_set1_epi8(10))));
+    return _mm_movemask_epi8(_mm_or_si128(isDigit, isAlpha)) == 0xFFFF;
+}
+
+// В каждом 16-битном слове старшая тетрада лежит в младшем байте, младшая - в старшем
+TARGET_SSSE3 inline __m128i joinNibblesSsse3(__m128i values) {
+    return _mm_or_si128(_mm_slli_epi16(_mm_and_si128(values, _mm_set1_epi16(0x00ff)), 4), _mm_srli_epi16(values, 8));
+}
+
+TARGET_SSSE3 size_t decodeHexSsse3(const unsigned char *in, size_t size, unsigned char *out) {
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m128i v0;
+        __m128i v1;
+        const bool ok0 = hexValuesSsse3(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)), v0);
+        const bool ok1 = hexValuesSsse3(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 16)), v1);
+        if (!ok0 || !ok1) {
+            break;
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i / 2), _mm_packus_epi16(joinNibblesSsse3(v0), joinNibblesSsse3(v1)));
+    }
+    return i;
+}
+
+// 12 байт входа в 16 индексов алфавита (W. Mula, D. Lemire: Faster Base64 Encoding and Decoding using AVX2 Instructions)
+TARGET_SSSE3 inline __m128i base64IndicesSsse3(__m128i in) {
+    in = _mm_shuffle_epi8(in, _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+    const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+    const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+    const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+    return _mm_or_si128(t1, t3);
+}
+
+TARGET_SSSE3 inline __m128i base64CharsSsse3(__m128i indices) {
+    const __m128i shiftLut = _mm_setr_epi8(
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0
+    );
+    __m128i result = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    const __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+    result = _mm_or_si128(result, _mm_and_si128(less, _mm_set1_epi8(13)));
+    return _mm_add_epi8(_mm_shuffle_epi8(shiftLut, result), indices);
+}
+
+TARGET_SSSE3 size_t encodeBase64Ssse3(const unsigned char *in, size_t size, unsigned char *out) {
+    size_t i = 0;
+    size_t o = 0;
+    // Читается 16 байт, используется 12
+    for (; i + 16 <= size; i += 12, o += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + o), base64CharsSsse3(base64IndicesSsse3(v)));
+    }
+    return i;
+}
+
+TARGET_SSSE3 inline bool base64ValuesSsse3(__m128i in, __m128i &values) {
+    const char lInv = 1;
+    const char hInv = 0;
+    const __m128i lowerLut = _mm_setr_epi8(lInv, lInv, 0x2b, 0x30, 0x41, 0x50, 0x61, 0x70, lInv, lInv, lInv, lInv, lInv, lInv, lInv, lInv);
+    const __m128i upperLut = _mm_setr_epi8(hInv, hInv, 0x2b, 0x39, 0x4f, 0x5a, 0x6f, 0x7a, hInv, hInv, hInv, hInv, hInv, hInv, hInv, hInv);
+    const __m128i shiftLut = _mm_setr_epi8(0, 0, 0x3e - 0x2b, 0x34 - 0x30, 0x00 - 0x41, 0x0f - 0x50, 0x1a - 0x61, 0x29 - 0x70, 0, 0, 0, 0, 0, 0, 0, 0);
+
+    const __m128i higherNibble = _mm_and_si128(_mm_srli_epi32(in, 4), _mm_set1_epi8(0x0f));
+    const __m128i below = _mm_cmplt_epi8(in, _mm_shuffle_epi8(lowerLut, higherNibble));
+    const __m128i above = _mm_cmpgt_epi8(in, _mm_shuffle_epi8(upperLut, higherNibble));
+    const __m128i eqSlash = _mm_cmpeq_epi8(in, _mm_set1_epi8('/'));
+    const __m128i outside = _mm_andnot_si128(eqSlash, _mm_or_si128(below, above));
+    if (_mm_movemask_epi8(outside) != 0) {
+        return false;
+    }
+    const __m128i shifted = _mm_add_epi8(in, _mm_shuffle_epi8(shiftLut, higherNibble));
+    values = _mm_add_epi8(shifted, _mm_and_si128(eqSlash, _mm_set1_epi8(-3)));
+    return true;
+}
+
+// 16 значений по 6 бит в 12 байт в начале регистра
+TARGET_SSSE3 inline __m128i base64PackSsse3(__m128i values) {
+    const __m128i mergeAbBc = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+    const __m128i merged = _mm_madd_epi16(mergeAbBc, _mm_set1_epi32(0x00011000));
+    return _mm_shuffle_epi8(merged, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+}
+
+TARGET_SSSE3 size_t decodeBase64Ssse3(const unsigned char *in, size_t size, unsigned char *out) {
+    size_t i = 0;
+    size_t o = 0;
+    // Пишется 16 байт, полезных 12. Хвост из двух четверок с возможным '=' остается скалярному коду и дает запас под лишние 4 байта
+    for (; i + 16 + 8 <= size; i += 16, o += 12) {
+        __m128i values;
+        if (!base64ValuesSsse3(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)), values)) {
+            break;
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + o), base64PackSsse3(values));
+    }
+    return i;
+}
+
+////////////
+/// AVX2 ///
+////////////
+
+#define CODECS_REPEAT_16(a0, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15) \
+    a0, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, \
+    a0, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15
+
+TARGET_AVX2 size_t encodeHexAvx2(const unsigned char *in, size_t size, unsigned char *out) {
+    const __m256i lut = _mm256_setr_epi8(CODECS_REPEAT_16('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'));
+    const __m256i mask = _mm256_set1_epi8(0x0f);
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        const __m256i hi = _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), mask));
+        const __m256i lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(v, mask));
+        // unpack работает внутри 128-битных половин: low содержит байты 0-7 и 16-23, high - 8-15 и 24-31
+        const __m256i low = _mm256_unpacklo_epi8(hi, lo);
+        const __m256i high = _mm256_unpackhi_epi8(hi, lo);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 2 * i), _mm256_permute2x128_si256(low, high, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 2 * i + 32), _mm256_permute2x128_si256(low, high, 0x31));
+    }
+    return i;
+}
+
+TARGET_AVX2 inline bool hexValuesAvx2(__m256i c, __m256i &values) {
+    const __m256i digit = _mm256_sub_epi8(c, _mm256_set1_epi8('0'));
+    const __m256i isDigit = _mm256_cmpeq_epi8(_mm256_min_epu8(digit, _mm256_set1_epi8(9)), digit);
+    const __m256i alpha = _mm256_sub_epi8(_mm256_or_si256(c, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+    const __m256i isAlpha = _mm256_cmpeq_epi8(_mm256_min_epu8(alpha, _mm256_set1_epi8(5)), alpha);
+    values = _mm256_or_si256(_mm256_and_si256(isDigit, digit), _mm256_and_si256(isAlpha, _mm256_add_epi8(alpha, _mm256_set1_epi8(10))));
+    return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(isDigit, isAlpha))) == 0xFFFFFFFFu;
+}
+
+TARGET_AVX2 inline __m256i joinNibblesAvx2(__m256i values) {
+    return _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(values, _mm256_set1_epi16(0x00ff)), 4), _mm256_srli_epi16(values, 8));
+}
+
+TARGET_AVX2 size_t decodeHexAvx2(const unsigned char *in, size_t size, unsigned char *out) {
+    size_t i = 0;
+    for (; i + 64 <= size; i += 64) {
+        __m256i v0;
+        __m256i v1;
+        const bool ok0 = hexValuesAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i)), v0);
+        const bool ok1 = hexValuesAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i + 32)), v1);
+        if (!ok0 || !ok1) {
+            break;
+        }
+        // packus тоже работает по половинам, возвращаем порядок четвертей
+        const __m256i packed = _mm256_packus_epi16(joinNibblesAvx2(v0), joinNibblesAvx2(v1));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i / 2), _mm256_permute4x64_epi64(packed, 0xD8));
+    }
+    return i;
+}
+
+TARGET_AVX2 size_t encodeBase64Avx2(const unsigned char *in, size_t size, unsigned char *out) {
+    const __m256i shuffle = _mm256_setr_epi8(CODECS_REPEAT_16(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+    const __m256i shiftLut = _mm256_setr_epi8(CODECS_REPEAT_16(
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0
+    ));
+    size_t i = 0;
+    size_t o = 0;
+    // В каждую половину по 12 байт, вторая половина читает 16 байт начиная с 12-го
+    for (; i + 28 <= size; i += 24, o += 32) {
+        const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 12));
+        __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+        v = _mm256_shuffle_epi8(v, shuffle);
+        const __m256i t0 = _mm256_and_si256(v, _mm256_set1_epi32(0x0fc0fc00));
+        const __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+        const __m256i t2 = _mm256_and_si256(v, _mm256_set1_epi32(0x003f03f0));
+        const __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+        const __m256i indices = _mm256_or_si256(t1, t3);
+
+        __m256i result = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+        const __m256i less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+        result = _mm256_or_si256(result, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+        result = _mm256_add_epi8(_mm256_shuffle_epi8(shiftLut, result), indices);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + o), result);
+    }
+    return i;
+}
+
+TARGET_AVX2 size_t decodeBase64Avx2(const unsigned char *in, size_t size, unsigned char *out) {
+    const char lInv = 1;
+    const char hInv = 0;
+    const __m256i lowerLut = _mm256_setr_epi8(CODECS_REPEAT_16(lInv, lInv, 0x2b, 0x30, 0x41, 0x50, 0x61, 0x70, lInv, lInv, lInv, lInv, lInv, lInv, lInv, lInv));
+    const __m256i upperLut = _mm256_setr_epi8(CODECS_REPEAT_16(hInv, hInv, 0x2b, 0x39, 0x4f, 0x5a, 0x6f, 0x7a, hInv, hInv, hInv, hInv, hInv, hInv, hInv, hInv));
+    const __m256i shiftLut = _mm256_setr_epi8(CODECS_REPEAT_16(0, 0, 0x3e - 0x2b, 0x34 - 0x30, 0x00 - 0x41, 0x0f - 0x50, 0x1a - 0x61, 0x29 - 0x70, 0, 0, 0, 0, 0, 0, 0, 0));
+    const __m256i pack = _mm256_setr_epi8(CODECS_REPEAT_16(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    size_t i = 0;
+    size_t o = 0;
+    // Пишется 32 байта, полезных 24. Хвост от 16 символов дает запас под лишние 8 байт
+    for (; i + 32 + 16 <= size; i += 32, o += 24) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        const __m256i higherNibble = _mm256_and_si256(_mm256_srli_epi32(v, 4), _mm256_set1_epi8(0x0f));
+        const __m256i below = _mm256_cmpgt_epi8(_mm256_shuffle_epi8(lowerLut, higherNibble), v);
+        const __m256i above = _mm256_cmpgt_epi8(v, _mm256_shuffle_epi8(upperLut, higherNibble));
+        const __m256i eqSlash = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('/'));
+        const __m256i outside = _mm256_andnot_si256(eqSlash, _mm256_or_si256(below, above));
+        if (_mm256_movemask_epi8(outside) != 0) {
+            break;
+        }
+        const __m256i shifted = _mm256_add_epi8(v, _mm256_shuffle_epi8(shiftLut, higherNibble));
+        const __m256i values = _mm256_add_epi8(shifted, _mm256_and_si256(eqSlash, _mm256_set1_epi8(-3)));
+
+        const __m256i mergeAbBc = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+        const __m256i merged = _mm256_madd_epi16(mergeAbBc, _mm256_set1_epi32(0x00011000));
+        const __m256i packed = _mm256_shuffle_epi8(merged, pack);
+        // По 12 байт из каждой половины подряд
+        const __m256i result = _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + o), result);
+    }
+    return i;
+}
+
+#undef CODECS_REPEAT_16
+
+#endif // CODECS_X86
+
+bool isSupported(CodecsKernel kernel) {
+    switch (kernel) {
+    case CodecsKernel::Scalar:
+        return true;
+#ifdef CODECS_X86
+    case CodecsKernel::Ssse3:
+        return cpuFeatures().ssse3;
+    case CodecsKernel::Avx2:
+        return cpuFeatures().avx2;
+#endif
+    default:
+        return false;
+    }
+}
+
+CodecsKernel bestKernel() {
+    if (isSupported(CodecsKernel::Avx2)) {
+        return CodecsKernel::Avx2;
+    }
+    if (isSupported(CodecsKernel::Ssse3)) {
+        return CodecsKernel::Ssse3;
+    }
+    return CodecsKernel::Scalar;
+}
+
+Kernel makeKernel(CodecsKernel kernel) {
+    Kernel result;
+#ifdef CODECS_X86
+    if (kernel == CodecsKernel::Ssse3) {
+        result.encodeHex = encodeHexSsse3;
+        result.decodeHex = decodeHexSsse3;
+        result.encodeBase64 = encodeBase64Ssse3;
+        result.decodeBase64 = decodeBase64Ssse3;
+    } else if (kernel == CodecsKernel::Avx2) {
+        result.encodeHex = encodeHexAvx2;
+        result.decodeHex = decodeHexAvx2;
+        result.encodeBase64 = encodeBase64Avx2;
+        result.decodeBase64 = decodeBase64Avx2;
+    }
+#else
+    (void)kernel;
+#endif
+    return result;
+}
+
+std::atomic<int> selectedKernel(static_cast<int>(CodecsKernel::Auto));
+
+CodecsKernel currentKernelType() {
+    CodecsKernel kernel = static_cast<CodecsKernel>(selectedKernel.load(std::memory_order_relaxed));
+    if (kernel == CodecsKernel::Auto) {
+        kernel = bestKernel();
+        selectedKernel.store(static_cast<int>(kernel), std::memory_order_relaxed);
+    }
+    return kernel;
+}
+
+const Kernel& currentKernel() {
+    static const Kernel kernels[] = {
+        makeKernel(CodecsKernel::Scalar),
+        makeKernel(CodecsKernel::Scalar),
+        makeKernel(CodecsKernel::Ssse3),
+        makeKernel(CodecsKernel::Avx2)
+    };
+    return kernels[static_cast<int>(currentKernelType())];
+}
+
+}
+
+bool setCodecsKernel(CodecsKernel kernel) {
+    if (kernel == CodecsKernel::Auto) {
+        kernel = bestKernel();
+    }
+    if (!isSupported(kernel)) {
+        return false;
+    }
+    selectedKernel.store(static_cast<int>(kernel), std::memory_order_relaxed);
+    return true;
+}
+
+CodecsKernel getCodecsKernel() {
+    return currentKernelType();
+}
+
+bool isCodecsKernelSupported(CodecsKernel kernel) {
+    return isSupported(kernel);
+}
+
+const char* codecsKernelName(CodecsKernel kernel) {
+    switch (kernel) {
+    case CodecsKernel::Auto:
+        return "auto";
+    case CodecsKernel::Scalar:
+        return "scalar";
+    case CodecsKernel::Ssse3:
+        return "ssse3";
+    case CodecsKernel::Avx2:
+        return "avx2";
+    default:
+        return "unknown";
+    }
+}
+
+size_t hexEncodedSize(size_t size) {
+    return size * 2;
+}
+
+void encodeHex(const char *data, size_t size, char *out) {
+    const unsigned char *in = reinterpret_cast<const unsigned char*>(data);
+    unsigned char *o = reinterpret_cast<unsigned char*>(out);
+    size_t i = currentKernel().encodeHex(in, size, o);
+    for (; i < size; i++) {
+        o[2 * i] = HEX_CHARS[in[i] >> 4];
+        o[2 * i + 1] = HEX_CHARS[in[i] & 0x0f];
+    }
+}
+
+size_t hexDecodedSize(size_t size) {
+    return size / 2;
+}
+
+bool decodeHex(const char *data, size_t size, char *out) {
+    if (size % 2 != 0) {
+        return false;
+    }
+    const unsigned char *in = reinterpret_cast<const unsigned char*>(data);
+    unsigned char *o = reinterpret_cast<unsigned char*>(out);
+    const unsigned char *table = decodeTables().hex;
+    size_t i = currentKernel().decodeHex(in, size, o);
+    for (; i < size; i += 2) {
+        const unsigned char hi = table[in[i]];
+        const unsigned char lo = table[in[i + 1]];
+        if (hi == INVALID || lo == INVALID) {
+            return false;
+        }
+        o[i / 2] = (hi << 4) | lo;
+    }
+    return true;
+}
+
+size_t base64EncodedSize(size_t size) {
+    return (size + 2) / 3 * 4;
+}
+
+void encodeBase64(const char *data, size_t size, char *out) {
+    const unsigned char *in = reinterpret_cast<const unsigned char*>(data);
+    unsigned char *o = reinterpret_cast<unsigned char*>(out);
+    size_t i = currentKernel().encodeBase64(in, size, o);
+    size_t j = i / 3 * 4;
+    for (; i + 3 <= size; i += 3, j += 4) {
+        const uint32_t v = (uint32_t(in[i]) << 16) | (uint32_t(in[i + 1]) << 8) | in[i + 2];
+        o[j] = BASE64_CHARS[(v >> 18) & 0x3f];
+        o[j + 1] = BASE64_CHARS[(v >> 12) & 0x3f];
+        o[j + 2] = BASE64_CHARS[(v >> 6) & 0x3f];
+        o[j + 3] = BASE64_CHARS[v & 0x3f];
+    }
+    if (i + 1 == size) {
+        const uint32_t v = uint32_t(in[i]) << 16;
+        o[j] = BASE64_CHARS[(v >> 18) & 0x3f];
+        o[j + 1] = BASE64_CHARS[(v >> 12) & 0x3f];
+        o[j + 2] = '=';
+        o[j + 3] = '=';
+    } else if (i + 2 == size) {
+        const uint32_t v = (uint32_t(in[i]) << 16) | (uint32_t(in[i + 1]) << 8);
+        o[j] = BASE64_CHARS[(v >> 18) & 0x3f];
+        o[j + 1] = BASE64_CHARS[(v >> 12) & 0x3f];
+        o[j + 2] = BASE64_CHARS[(v >> 6) & 0x3f];
+        o[j + 3] = '=';
+    }
+}
+
+size_t base64DecodedSize(const char *data, size_t size) {
+    size_t result = size / 4 * 3;
+    if (size >= 4 && size % 4 == 0) {
+        if (data[size - 1] == '=') {
+            result--;
+            if (data[size - 2] == '=') {
+                result--;
+            }
+        }
+    }
+    return result;
+}
+
+bool decodeBase64(const char *data, size_t size, char *out) {
+    if (size % 4 != 0) {
+        return false;
+    }
+    const unsigned char *in = reinterpret_cast<const unsigned char*>(data);
+    unsigned char *o = reinterpret_cast<unsigned char*>(out);
+    const unsigned char *table = decodeTables().base64;
+    size_t i = currentKernel().decodeBase64(in, size, o);
+    size_t j = i / 4 * 3;
+    for (; i < size; i += 4, j += 3) {
+        const unsigned char c0 = table[in[i]];
+        const unsigned char c1 = table[in[i + 1]];
+        unsigned char c2 = table[in[i + 2]];
+        unsigned char c3 = table[in[i + 3]];
+        size_t count = 3;
+        if (i + 4 == size && in[i + 3] == '=') {
+            c3 = 0;
+            count = 2;
+            if (in[i + 2] == '=') {
+                c2 = 0;
+                count = 1;
+            }
+        }
+        if (c0 == INVALID || c1 == INVALID || c2 == INVALID || c3 == INVALID) {
+            return false;
+        }
+        const uint32_t v = (uint32_t(c0) << 18) | (uint32_t(c1) << 12) | (uint32_t(c2) << 6) | c3;
+        o[j] = (v >> 16) & 0xff;
+        if (count >= 2) {
+            o[j + 1] = (v >> 8) & 0xff;
+        }
+        if (count == 3) {
+            o[j + 2] = v & 0xff;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,47 @@
+#ifndef CODECS_H
+#define CODECS_H
+
+#include <cstddef>
+
+/*
+   Кодирование hex и base64 без промежуточных буферов: вход и выход - готовые участки памяти,
+   размер выхода считается заранее функциями *Size. На x86 основную часть данных обрабатывают
+   векторные ядра (SSSE3 или AVX2 по CPUID), хвост и остальные платформы - скалярный код.
+   Декодирование строгое: любой символ вне алфавита дает false.
+   */
+
+enum class CodecsKernel {
+    Auto, Scalar, Ssse3, Avx2
+};
+
+// false, если ядро не поддерживается процессором
+bool setCodecsKernel(CodecsKernel kernel);
+
+CodecsKernel getCodecsKernel();
+
+bool isCodecsKernelSupported(CodecsKernel kernel);
+
+const char* codecsKernelName(CodecsKernel kernel);
+
+size_t hexEncodedSize(size_t size);
+
+// Нижний регистр, как у QByteArray::toHex
+void encodeHex(const char *data, size_t size, char *out);
+
+size_t hexDecodedSize(size_t size);
+
+// Длина должна быть четной, регистр любой
+bool decodeHex(const char *data, size_t size, char *out);
+
+size_t base64EncodedSize(size_t size);
+
+// Стандартный алфавит с выравниванием '='
+void encodeBase64(const char *data, size_t size, char *out);
+
+// Для входа длины не кратной 4 результат не имеет смысла, decodeBase64 на нем вернет false
+size_t base64DecodedSize(const char *data, size_t size);
+
+// Только стандартный алфавит, длина кратна 4, '=' допустимо лишь в конце
+bool decodeBase64(const char *data, size_t size, char *out);
+
+#endif // CODECS_H
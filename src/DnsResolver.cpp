@@ -0,0 +1,186 @@
+#include "DnsResolver.h"
+
+#include <QUdpSocket>
+#include <QTimer>
+#include <QThread>
+
+#include <random>
+#include <limits>
+
+#include "dns/dnspacket.h"
+
+#include "check.h"
+#include "Log.h"
+#include "SlotWrapper.h"
+
+const static QHostAddress DEFAULT_DNS_SERVER("8.8.8.8");
+const static quint16 DEFAULT_DNS_PORT = 53;
+
+const static milliseconds DEFAULT_TIMEOUT = 2s;
+const static size_t DEFAULT_RETRIES = 2;
+
+const static int DNS_HEADER_SIZE = 12;
+
+static QString normalizeName(const QString &name) {
+    QString result = name.toLower();
+    if (result.endsWith('.')) {
+        result.chop(1);
+    }
+    return result;
+}
+
+DnsResolver::DnsResolver(QObject *parent)
+    : QObject(parent)
+    , serverAddress(DEFAULT_DNS_SERVER)
+    , serverPort(DEFAULT_DNS_PORT)
+    , timeout(DEFAULT_TIMEOUT)
+    , retries(DEFAULT_RETRIES)
+{
+    std::random_device rd;
+    nextId = std::uniform_int_distribution<quint16>()(rd);
+}
+
+void DnsResolver::setServer(const QHostAddress &address, quint16 port) {
+    serverAddress = address;
+    serverPort = port;
+}
+
+void DnsResolver::setTimeout(milliseconds timeout, size_t retries) {
+    this->timeout = timeout;
+    this->retries = retries;
+}
+
+void DnsResolver::createSocket() {
+    if (socket != nullptr) {
+        return;
+    }
+    // Создаются в потоке объекта, а не в конструкторе, иначе нотификаторы сокета и таймера окажутся в чужом потоке
+    socket = new QUdpSocket(this);
+    CHECK(connect(socket, SIGNAL(readyRead()), this, SLOT(onReadyRead())), "not connect readyRead");
+    timer = new QTimer(this);
+    timer->setSingleShot(true);
+    CHECK(connect(timer, SIGNAL(timeout()), this, SLOT(onTimerEvent())), "not connect timeout");
+    CHECK(timer->connect(thread(), SIGNAL(finished()), SLOT(stop())), "not connect finished");
+}
+
+void DnsResolver::resolve(const QString &name, const DnsCallback &callback) {
+    createSocket();
+    CHECK(queries.size() < std::numeric_limits<quint16>::max(), "Too many dns queries");
+    while (queries.find(nextId) != queries.end()) {
+        nextId++;
+    }
+    const quint16 id = nextId++;
+
+    DnsPacket requestPacket;
+    requestPacket.setId(id);
+    requestPacket.addQuestion(DnsQuestion::getIp(name));
+    requestPacket.setFlags(DnsFlag::MyFlag);
+
+    Query &query = queries[id];
+    query.name = name;
+    query.callback = callback;
+    query.request = requestPacket.toByteArray();
+    sendQuery(query);
+    restartTimer();
+}
+
+void DnsResolver::sendQuery(Query &query) {
+    query.attempt++;
+    query.deadline = ::now() + timeout;
+    const qint64 sended = socket->writeDatagram(query.request, serverAddress, serverPort);
+    if (sended != query.request.size()) {
+        LOG << "Dns send error " << query.name << ". " << socket->errorString();
+    }
+}
+
+void DnsResolver::finishQuery(quint16 id, const std::vector<QString> &ips, const std::string &error) {
+    auto found = queries.find(id);
+    CHECK(found != queries.end(), "Dns query not found");
+    const Query query = std::move(found->second);
+    queries.erase(found);
+    restartTimer();
+
+    query.callback(query.name, ips, error);
+}
+
+void DnsResolver::restartTimer() {
+    if (queries.empty()) {
+        timer->stop();
+        return;
+    }
+    time_point nearest = queries.begin()->second.deadline;
+    for (const auto &pair: queries) {
+        nearest = std::min(nearest, pair.second.deadline);
+    }
+    const milliseconds wait = std::max(std::chrono::duration_cast<milliseconds>(nearest - ::now()), 0ms);
+    timer->start(wait.count());
+}
+
+void DnsResolver::onReadyRead() {
+BEGIN_SLOT_WRAPPER
+    while (socket->hasPendingDatagrams()) {
+        const qint64 pendingSize = socket->pendingDatagramSize();
+        QByteArray data(std::max(pendingSize, qint64(0)), 0);
+        QHostAddress sender;
+        quint16 senderPort = 0;
+        const qint64 size = socket->readDatagram(data.data(), data.size(), &sender, &senderPort);
+        if (size < DNS_HEADER_SIZE) {
+            continue;
+        }
+        data.resize(size);
+        if (!sender.isEqual(serverAddress, QHostAddress::TolerantConversion) || senderPort != serverPort) {
+            LOG << "Dns response from unknown server " << sender.toString();
+            continue;
+        }
+
+        const quint16 id = (quint16(quint8(data[0])) << 8) | quint8(data[1]);
+        auto found = queries.find(id);
+        if (found == queries.end()) {
+            // Ответ на уже завершенный или повторенный запрос
+            continue;
+        }
+
+        const DnsPacket packet = DnsPacket::fromBytesArary(data);
+        if (packet.questions().size() != 1 || normalizeName(QString(packet.questions()[0].domainName())) != normalizeName(found->second.name)) {
+            LOG << "Dns response for other question " << found->second.name;
+            continue;
+        }
+
+        std::vector<QString> ips;
+        for (const auto &record : packet.answers()) {
+            if (record.type() == RRTypes::A) {
+                ips.emplace_back(record.toString());
+            }
+        }
+        LOG << "dns ok " << found->second.name << ". " << ips.size();
+        if (ips.empty()) {
+            finishQuery(id, ips, "Empty dns response");
+        } else {
+            finishQuery(id, ips, "");
+        }
+    }
+END_SLOT_WRAPPER
+}
+
+void DnsResolver::onTimerEvent() {
+BEGIN_SLOT_WRAPPER
+    const time_point now = ::now();
+    std::vector<quint16> expired;
+    for (auto &pair: queries) {
+        Query &query = pair.second;
+        if (query.deadline > now) {
+            continue;
+        }
+        if (query.attempt <= retries) {
+            LOG << "Dns timeout " << query.name << ". Retry " << query.attempt;
+            sendQuery(query);
+        } else {
+            expired.emplace_back(pair.first);
+        }
+    }
+    for (const quint16 id: expired) {
+        finishQuery(id, {}, "Dns timeout");
+    }
+    restartTimer();
+END_SLOT_WRAPPER
+}
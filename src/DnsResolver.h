@@ -0,0 +1,83 @@
+#ifndef DNSRESOLVER_H
+#define DNSRESOLVER_H
+
+#include <QObject>
+#include <QHostAddress>
+#include <QByteArray>
+
+#include <functional>
+#include <map>
+#include <vector>
+
+#include "duration.h"
+
+class QUdpSocket;
+class QTimer;
+
+using DnsCallback = std::function<void(const QString &name, const std::vector<QString> &ips, const std::string &error)>;
+
+/*
+   Асинхронный резолвер A-записей поверх одного QUdpSocket.
+   Все запросы отправляются сразу, ответы сопоставляются по id пакета.
+   Использовать только из потока, в котором живет объект.
+*/
+class DnsResolver : public QObject
+{
+    Q_OBJECT
+public:
+
+    explicit DnsResolver(QObject *parent = nullptr);
+
+    void setServer(const QHostAddress &address, quint16 port);
+
+    // timeout на одну попытку, после retries повторов callback вызывается с ошибкой
+    void setTimeout(milliseconds timeout, size_t retries);
+
+    void resolve(const QString &name, const DnsCallback &callback);
+
+private slots:
+
+    void onReadyRead();
+
+    void onTimerEvent();
+
+private:
+
+    struct Query {
+        QString name;
+        DnsCallback callback;
+        QByteArray request;
+        size_t attempt = 0;
+        time_point deadline;
+    };
+
+private:
+
+    void createSocket();
+
+    void sendQuery(Query &query);
+
+    void finishQuery(quint16 id, const std::vector<QString> &ips, const std::string &error);
+
+    void restartTimer();
+
+private:
+
+    QHostAddress serverAddress;
+
+    quint16 serverPort;
+
+    milliseconds timeout;
+
+    size_t retries;
+
+    QUdpSocket *socket = nullptr;
+
+    QTimer *timer = nullptr;
+
+    std::map<quint16, Query> queries;
+
+    quint16 nextId;
+};
+
+#endif // DNSRESOLVER_H
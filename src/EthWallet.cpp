@@ -44,6 +44,17 @@ EthWallet::EthWallet(
     : EthWallet(readFile(getFullPath(folder, address)), address, password, true)
 {}
 
+EthWallet::EthWallet(const std::string &address, const SecureBytes &rawPrivateKey)
+    : rawprivkey(rawPrivateKey)
+    , address(address)
+{
+    CHECK_TYPED(rawprivkey.size() == size_t(EC_KEY_LENGTH), TypeErrors::PRIVATE_KEY_ERROR, "Incorrect private key");
+}
+
+SecureBytes EthWallet::getRawPrivateKey() const {
+    return rawprivkey;
+}
+
 std::string EthWallet::getAddress() const {
     return address;
 }
@@ -87,17 +98,26 @@ std::vector<std::pair<QString, QString>> EthWallet::getAllWalletsInFolder(const
     const QDir dir(folder);
     const QStringList allFiles = dir.entryList(QDir::NoDotAndDotDot | QDir::System | QDir::Hidden  | QDir::AllDirs | QDir::Files, QDir::DirsFirst);
     for (const QString &file: allFiles) {
-        const std::string fileName = file.toStdString();
-        if (fileName.substr(0, 2) == "0x") {
-            const std::string addressPart = fileName.substr(2);
-            const std::string address = "0x" + MixedCaseEncoding(HexStringToDump(addressPart));
-            result.emplace_back(QString::fromStdString(address), getFullPath(folder, address));
+        std::pair<QString, QString> wallet;
+        if (parseWalletFile(folder, file, wallet)) {
+            result.emplace_back(wallet);
         }
     }
 
     return result;
 }
 
+bool EthWallet::parseWalletFile(const QString &folder, const QString &file, std::pair<QString, QString> &wallet) {
+    const std::string fileName = file.toStdString();
+    if (fileName.substr(0, 2) != "0x") {
+        return false;
+    }
+    const std::string addressPart = fileName.substr(2);
+    const std::string address = "0x" + MixedCaseEncoding(HexStringToDump(addressPart));
+    wallet = std::make_pair(QString::fromStdString(address), getFullPath(folder, address));
+    return true;
+}
+
 std::string EthWallet::makeErc20Data(const std::string &valueHex, const std::string &address) {
     std::string result = "0xa9059cbb";
 
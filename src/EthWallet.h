@@ -6,6 +6,8 @@
 
 #include <QString>
 
+#include "SecureMemory.h"
+
 class EthWallet {
 public:
 
@@ -19,6 +21,11 @@ public:
         std::string password
     );
 
+    // Ключ из сессии (KeySessions), без чтения файла и scrypt
+    EthWallet(const std::string &address, const SecureBytes &rawPrivateKey);
+
+    SecureBytes getRawPrivateKey() const;
+
     std::string SignTransaction(
         std::string nonce,
         std::string gasPrice,
@@ -42,6 +49,9 @@ public:
 
     static std::vector<std::pair<QString, QString>> getAllWalletsInFolder(const QString &folder);
 
+    // Разбирает один файл папки кошельков. false, если файл не кошелек
+    static bool parseWalletFile(const QString &folder, const QString &file, std::pair<QString, QString> &wallet);
+
     static std::string makeErc20Data(const std::string &valueHex, const std::string &address);
 
     static std::string getOneKey(const QString &folder, const std::string &address);
@@ -54,7 +64,7 @@ private:
 
 private:
 
-    std::vector<uint8_t> rawprivkey;
+    SecureBytes rawprivkey;
 
     std::string address;
 
@@ -0,0 +1,88 @@
+#include "HtmlManifest.h"
+
+#include <QFile>
+#include <QDir>
+#include <QDirIterator>
+#include <QCryptographicHash>
+#include <QJsonDocument>
+
+#include "check.h"
+#include "utils.h"
+
+const QString HTML_SERVICE_FILE_PREFIX = ".metagate_";
+
+const static QString MANIFEST_FILE = HTML_SERVICE_FILE_PREFIX + "manifest.json";
+
+QString fileMd5(const QString &filePath) {
+    QFile file(filePath);
+    CHECK(file.open(QIODevice::ReadOnly), "Not open file " + filePath.toStdString());
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    CHECK(hash.addData(&file), "Error read file " + filePath.toStdString());
+    return QString(hash.result().toHex());
+}
+
+HtmlManifest calcHtmlManifest(const QString &versionDir) {
+    HtmlManifest manifest;
+    const QDir dir(versionDir);
+    QDirIterator it(versionDir, QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        const QString filePath = it.next();
+        const QString relativePath = dir.relativeFilePath(filePath);
+        if (relativePath.startsWith(HTML_SERVICE_FILE_PREFIX)) {
+            continue;
+        }
+        manifest[relativePath] = fileMd5(filePath);
+    }
+    return manifest;
+}
+
+HtmlManifest loadHtmlManifest(const QString &versionDir) {
+    const QString manifestPath = makePath(versionDir, MANIFEST_FILE);
+    if (!isExistFile(manifestPath)) {
+        const HtmlManifest manifest = calcHtmlManifest(versionDir);
+        saveHtmlManifest(versionDir, manifest);
+        return manifest;
+    }
+    return readHtmlManifestFile(manifestPath);
+}
+
+void saveHtmlManifest(const QString &versionDir, const HtmlManifest &manifest) {
+    writeHtmlManifestFile(makePath(versionDir, MANIFEST_FILE), manifest);
+}
+
+HtmlManifest readHtmlManifestFile(const QString &manifestPath) {
+    const std::string content = readFileBinary(manifestPath);
+    const QJsonDocument document = QJsonDocument::fromJson(QByteArray(content.data(), content.size()));
+    CHECK(document.isObject(), "Incorrect manifest " + manifestPath.toStdString());
+    const QJsonObject root = document.object();
+    HtmlManifest manifest;
+    for (auto iter = root.begin(); iter != root.end(); ++iter) {
+        CHECK(iter.value().isString(), "Incorrect manifest " + manifestPath.toStdString());
+        manifest[iter.key()] = iter.value().toString();
+    }
+    return manifest;
+}
+
+void writeHtmlManifestFile(const QString &manifestPath, const HtmlManifest &manifest) {
+    writeToFileBinary(manifestPath, QJsonDocument(htmlManifestToJson(manifest)).toJson(QJsonDocument::Compact).toStdString(), false);
+}
+
+QJsonObject htmlManifestToJson(const HtmlManifest &manifest) {
+    QJsonObject result;
+    for (const auto &pair: manifest) {
+        result.insert(pair.first, pair.second);
+    }
+    return result;
+}
+
+bool isCorrectManifestPath(const QString &path) {
+    if (path.isEmpty() || path.startsWith(HTML_SERVICE_FILE_PREFIX) || QDir::isAbsolutePath(path) || path.contains('\\') || path.contains(':')) {
+        return false;
+    }
+    for (const QString &part: path.split('/')) {
+        if (part.isEmpty() || part == "." || part == "..") {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,33 @@
+#ifndef HTMLMANIFEST_H
+#define HTMLMANIFEST_H
+
+#include <map>
+
+#include <QString>
+#include <QJsonObject>
+
+// Путь файла относительно папки версии -> md5 в hex
+using HtmlManifest = std::map<QString, QString>;
+
+// Служебные файлы в папке версии (манифест, упаковка) начинаются с этого префикса и в манифест не входят
+const extern QString HTML_SERVICE_FILE_PREFIX;
+
+QString fileMd5(const QString &filePath);
+
+HtmlManifest calcHtmlManifest(const QString &versionDir);
+
+// Манифест хранится в папке версии. Если его нет (версия распакована из архива), он считается и сохраняется
+HtmlManifest loadHtmlManifest(const QString &versionDir);
+
+void saveHtmlManifest(const QString &versionDir, const HtmlManifest &manifest);
+
+HtmlManifest readHtmlManifestFile(const QString &manifestPath);
+
+void writeHtmlManifestFile(const QString &manifestPath, const HtmlManifest &manifest);
+
+QJsonObject htmlManifestToJson(const HtmlManifest &manifest);
+
+// Пути приходят с сервера, они не должны выходить за пределы папки версии
+bool isCorrectManifestPath(const QString &path);
+
+#endif // HTMLMANIFEST_H
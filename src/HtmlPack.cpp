@@ -0,0 +1,122 @@
+#include "HtmlPack.h"
+
+#include <cstring>
+#include <vector>
+
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QtEndian>
+
+#include "check.h"
+#include "utils.h"
+
+// Заголовок: MAGIC, размер индекса (uint32 little endian), индекс в json {path: [offset, size]}
+const static QByteArray MAGIC = "MGPACK1\n";
+
+const static qint64 HEADER_SIZE = 8 + 4;
+
+QString HtmlPack::packPath(const QString &versionDir) {
+    return makePath(versionDir, HTML_SERVICE_FILE_PREFIX + "pack");
+}
+
+void HtmlPack::write(const QString &versionDir, const HtmlManifest &manifest) {
+    QJsonObject index;
+    qint64 offset = 0;
+    for (const auto &pair: manifest) {
+        const qint64 size = QFileInfo(makePath(versionDir, pair.first)).size();
+        index.insert(pair.first, QJsonArray{double(offset), double(size)});
+        offset += size;
+    }
+    const QByteArray indexData = QJsonDocument(index).toJson(QJsonDocument::Compact);
+
+    // Пишется во временный файл и переименовывается, чтобы open никогда не увидел недописанную упаковку
+    const QString resultPath = packPath(versionDir);
+    const QString path = resultPath + ".tmp";
+    QFile file(path);
+    CHECK(file.open(QIODevice::WriteOnly), "Not open file " + path.toStdString());
+    CHECK(file.resize(HEADER_SIZE + indexData.size() + offset), "Error resize file " + path.toStdString());
+    uchar indexSize[4];
+    qToLittleEndian<quint32>(quint32(indexData.size()), indexSize);
+    CHECK(file.write(MAGIC) == MAGIC.size(), "Error write file " + path.toStdString());
+    CHECK(file.write(reinterpret_cast<const char*>(indexSize), sizeof(indexSize)) == sizeof(indexSize), "Error write file " + path.toStdString());
+    CHECK(file.write(indexData) == indexData.size(), "Error write file " + path.toStdString());
+
+    std::vector<char> buffer(64 * 1024);
+    for (const auto &pair: manifest) {
+        const QString filePath = makePath(versionDir, pair.first);
+        QFile inFile(filePath);
+        CHECK(inFile.open(QIODevice::ReadOnly), "Not open file " + filePath.toStdString());
+        qint64 readLen;
+        while ((readLen = inFile.read(buffer.data(), buffer.size())) > 0) {
+            CHECK(file.write(buffer.data(), readLen) == readLen, "Error write file " + path.toStdString());
+        }
+        CHECK(readLen == 0, "Error read file " + filePath.toStdString());
+    }
+    CHECK(file.pos() == file.size(), "Files changed while packing " + versionDir.toStdString());
+    file.close();
+
+    removeFile(resultPath);
+    CHECK(QFile::rename(path, resultPath), "Not rename file " + path.toStdString());
+}
+
+std::shared_ptr<HtmlPack> HtmlPack::open(const QString &versionDir) {
+    const auto pack = std::make_shared<HtmlPack>(packPath(versionDir));
+    if (!pack->load()) {
+        return nullptr;
+    }
+    return pack;
+}
+
+HtmlPack::HtmlPack(const QString &path)
+    : file(path)
+{}
+
+bool HtmlPack::load() {
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const qint64 fileSize = file.size();
+    if (fileSize < HEADER_SIZE) {
+        return false;
+    }
+    mapped = file.map(0, fileSize);
+    if (mapped == nullptr || std::memcmp(mapped, MAGIC.data(), MAGIC.size()) != 0) {
+        return false;
+    }
+    const qint64 indexSize = qFromLittleEndian<quint32>(mapped + MAGIC.size());
+    if (HEADER_SIZE + indexSize > fileSize) {
+        return false;
+    }
+    const QJsonDocument document = QJsonDocument::fromJson(QByteArray::fromRawData(reinterpret_cast<const char*>(mapped + HEADER_SIZE), int(indexSize)));
+    if (!document.isObject()) {
+        return false;
+    }
+
+    const qint64 dataBegin = HEADER_SIZE + indexSize;
+    const QJsonObject index = document.object();
+    for (auto iter = index.begin(); iter != index.end(); ++iter) {
+        const QJsonArray entryJson = iter.value().toArray();
+        if (entryJson.size() != 2 || !entryJson[0].isDouble() || !entryJson[1].isDouble()) {
+            return false;
+        }
+        Entry entry;
+        entry.offset = dataBegin + qint64(entryJson[0].toDouble());
+        entry.size = qint64(entryJson[1].toDouble());
+        if (entry.offset < dataBegin || entry.size < 0 || entry.offset + entry.size > fileSize) {
+            return false;
+        }
+        entries[iter.key()] = entry;
+    }
+    return true;
+}
+
+bool HtmlPack::find(const QString &path, QByteArray &data) const {
+    const auto found = entries.find(path);
+    if (found == entries.end()) {
+        return false;
+    }
+    data = QByteArray::fromRawData(reinterpret_cast<const char*>(mapped + found->second.offset), int(found->second.size));
+    return true;
+}
@@ -0,0 +1,52 @@
+#ifndef HTMLPACK_H
+#define HTMLPACK_H
+
+#include <map>
+#include <memory>
+
+#include <QString>
+#include <QByteArray>
+#include <QFile>
+
+#include "HtmlManifest.h"
+
+/*
+   Все файлы версии интерфейса одним файлом: индекс и затем содержимое файлов подряд.
+   Упаковка отображается в память, поэтому ресурсы отдаются без открытия тысяч отдельных файлов.
+   */
+class HtmlPack {
+public:
+
+    struct Entry {
+        qint64 offset;
+        qint64 size;
+    };
+
+public:
+
+    static void write(const QString &versionDir, const HtmlManifest &manifest);
+
+    // nullptr, если упаковки нет или она повреждена
+    static std::shared_ptr<HtmlPack> open(const QString &versionDir);
+
+    explicit HtmlPack(const QString &path);
+
+    // data ссылается на отображенную память и действительна, пока жив HtmlPack
+    bool find(const QString &path, QByteArray &data) const;
+
+private:
+
+    static QString packPath(const QString &versionDir);
+
+    bool load();
+
+private:
+
+    QFile file;
+
+    const uchar *mapped = nullptr;
+
+    std::map<QString, Entry> entries;
+};
+
+#endif // HTMLPACK_H
@@ -0,0 +1,138 @@
+#include "HtmlStore.h"
+
+#include <set>
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDirIterator>
+
+#ifdef TARGET_WINDOWS
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "check.h"
+#include "utils.h"
+
+static bool isCorrectHash(const QString &hash) {
+    if (hash.size() != 32) {
+        return false;
+    }
+    for (const QChar c: hash) {
+        if (!(('0' <= c && c <= '9') || ('a' <= c && c <= 'f'))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool makeHardLink(const QString &from, const QString &to) {
+#ifdef TARGET_WINDOWS
+    return CreateHardLinkW(reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(to).utf16()), reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(from).utf16()), nullptr) != 0;
+#else
+    return ::link(QFile::encodeName(from).constData(), QFile::encodeName(to).constData()) == 0;
+#endif
+}
+
+static void linkOrCopy(const QString &from, const QString &to) {
+    if (makeHardLink(from, to)) {
+        return;
+    }
+    CHECK(QFile::copy(from, to), "Not copy file " + from.toStdString() + " to " + to.toStdString());
+}
+
+HtmlStore::HtmlStore(const QString &root)
+    : root(root)
+{}
+
+QString HtmlStore::blobPath(const QString &hash) const {
+    CHECK(isCorrectHash(hash), "Incorrect hash " + hash.toStdString());
+    return makePath(root, "blobs", hash.left(2), hash);
+}
+
+QString HtmlStore::manifestsPath() const {
+    return makePath(root, "manifests");
+}
+
+bool HtmlStore::contains(const QString &hash) const {
+    return isCorrectHash(hash) && isExistFile(blobPath(hash));
+}
+
+bool HtmlStore::containsVersion(const HtmlManifest &manifest) const {
+    for (const auto &pair: manifest) {
+        if (!contains(pair.second)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void HtmlStore::addFile(const QString &filePath, const QString &hash) {
+    const QString blob = blobPath(hash);
+    if (isExistFile(blob)) {
+        CHECK(QFile::remove(filePath), "Not remove file " + filePath.toStdString());
+        linkOrCopy(blob, filePath);
+    } else {
+        createFolder(QFileInfo(blob).absolutePath());
+        linkOrCopy(filePath, blob);
+    }
+}
+
+void HtmlStore::addVersion(const QString &versionDir, const HtmlManifest &manifest) {
+    for (const auto &pair: manifest) {
+        addFile(makePath(versionDir, pair.first), pair.second);
+    }
+}
+
+void HtmlStore::materialize(const QString &hash, const QString &targetPath) const {
+    const QString blob = blobPath(hash);
+    CHECK(isExistFile(blob), "Not found blob " + hash.toStdString());
+    createFolder(QFileInfo(targetPath).absolutePath());
+    linkOrCopy(blob, targetPath);
+}
+
+void HtmlStore::materializeVersion(const HtmlManifest &manifest, const QString &targetDir) const {
+    for (const auto &pair: manifest) {
+        CHECK(isCorrectManifestPath(pair.first), "Incorrect path " + pair.first.toStdString());
+        materialize(pair.second, makePath(targetDir, pair.first));
+    }
+}
+
+void HtmlStore::saveManifest(const QString &name, const HtmlManifest &manifest) {
+    createFolder(manifestsPath());
+    writeHtmlManifestFile(makePath(manifestsPath(), name + ".json"), manifest);
+}
+
+bool HtmlStore::findManifest(const QString &name, HtmlManifest &manifest) const {
+    const QString path = makePath(manifestsPath(), name + ".json");
+    if (!isExistFile(path)) {
+        return false;
+    }
+    manifest = readHtmlManifestFile(path);
+    return true;
+}
+
+void HtmlStore::collectGarbage(size_t keepManifests) {
+    std::set<QString> alive;
+    const QFileInfoList manifests = QDir(manifestsPath()).entryInfoList(QStringList() << "*.json", QDir::Files, QDir::Time);
+    for (int i = 0; i < manifests.size(); i++) {
+        const QString path = manifests[i].absoluteFilePath();
+        if (size_t(i) >= keepManifests) {
+            QFile::remove(path);
+            continue;
+        }
+        for (const auto &pair: readHtmlManifestFile(path)) {
+            alive.insert(pair.second);
+        }
+    }
+
+    QDirIterator it(makePath(root, "blobs"), QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        const QString blob = it.next();
+        if (alive.find(it.fileName()) == alive.end()) {
+            QFile::remove(blob);
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef HTMLSTORE_H
+#define HTMLSTORE_H
+
+#include <QString>
+
+#include "HtmlManifest.h"
+
+/*
+   Хранилище файлов интерфейса по md5. Папки версий собираются из жестких ссылок на блобы,
+   поэтому одинаковые файлы разных версий лежат на диске один раз.
+   Манифесты последних версий сохраняются, и версию можно собрать заново без сети.
+   */
+class HtmlStore {
+public:
+
+    explicit HtmlStore(const QString &root);
+
+    bool contains(const QString &hash) const;
+
+    bool containsVersion(const HtmlManifest &manifest) const;
+
+    // Если такой блоб уже есть, файл заменяется ссылкой на него, иначе файл становится блобом
+    void addFile(const QString &filePath, const QString &hash);
+
+    void addVersion(const QString &versionDir, const HtmlManifest &manifest);
+
+    // Жесткая ссылка на блоб, если файловая система их не поддерживает - копия
+    void materialize(const QString &hash, const QString &targetPath) const;
+
+    void materializeVersion(const HtmlManifest &manifest, const QString &targetDir) const;
+
+    void saveManifest(const QString &name, const HtmlManifest &manifest);
+
+    bool findManifest(const QString &name, HtmlManifest &manifest) const;
+
+    // Оставляет keepManifests последних манифестов и блобы, на которые они ссылаются
+    void collectGarbage(size_t keepManifests);
+
+private:
+
+    QString blobPath(const QString &hash) const;
+
+    QString manifestsPath() const;
+
+private:
+
+    const QString root;
+};
+
+#endif // HTMLSTORE_H
@@ -0,0 +1,243 @@
+#include "HttpCache.h"
+
+#include <vector>
+#include <iterator>
+
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QDir>
+
+#include "check.h"
+#include "utils.h"
+#include "Log.h"
+
+const static quint32 DISK_FORMAT_VERSION = 1;
+
+const static QString TMP_SUFFIX = ".tmp";
+
+// Большие ответы не кэшируем, чтобы одна запись не вытесняла весь кэш
+const static int MAX_ENTRY_SIZE = 4 * 1024 * 1024;
+
+bool HttpCache::Entry::isFresh() const {
+    return system_now() < expires;
+}
+
+bool HttpCache::Entry::hasValidators() const {
+    return !etag.isEmpty() || !lastModified.isEmpty();
+}
+
+HttpCache::HttpCache(const QString &diskPath, size_t maxMemorySize, size_t maxDiskSize)
+    : diskPath(diskPath)
+    , maxMemorySize(maxMemorySize)
+    , maxDiskSize(maxDiskSize)
+    , diskThread(1)
+{
+    createFolder(diskPath);
+    diskThread.post([this]{
+        loadDisk();
+    });
+}
+
+// diskThread дописывает оставшиеся записи в своем деструкторе
+HttpCache::~HttpCache() = default;
+
+QString HttpCache::makeKey(const QString &host, const QString &pathAndQuery) {
+    return host.toLower() + pathAndQuery;
+}
+
+system_time_point HttpCache::parseExpires(QNetworkReply &reply) {
+    const system_time_point now = system_now();
+    const QByteArray cacheControl = reply.rawHeader("Cache-Control").toLower();
+    for (const QByteArray &directive: cacheControl.split(',')) {
+        const QByteArray trimmed = directive.trimmed();
+        if (trimmed == "no-cache") {
+            return now;
+        }
+        if (trimmed.startsWith("max-age=")) {
+            bool ok = false;
+            const qint64 maxAge = trimmed.mid(8).toLongLong(&ok);
+            return ok && maxAge > 0 ? now + seconds(maxAge) : now;
+        }
+    }
+
+    if (reply.hasRawHeader("Expires")) {
+        const QDateTime expires = QDateTime::fromString(QString(reply.rawHeader("Expires")), Qt::RFC2822Date);
+        if (expires.isValid() && expires.toMSecsSinceEpoch() > 0) {
+            return std::max(now, intToSystemTimePoint(expires.toMSecsSinceEpoch()));
+        }
+    }
+    return now;
+}
+
+bool HttpCache::parseResponse(QNetworkReply &reply, Entry &entry) {
+    if (reply.attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() != 200) {
+        return false;
+    }
+    const QByteArray cacheControl = reply.rawHeader("Cache-Control").toLower();
+    if (cacheControl.contains("no-store")) {
+        return false;
+    }
+    const QByteArray vary = reply.rawHeader("Vary").trimmed().toLower();
+    if (!vary.isEmpty() && vary != "accept-encoding") {
+        return false;
+    }
+    const QVariant contentLength = reply.header(QNetworkRequest::ContentLengthHeader);
+    if (contentLength.isValid() && contentLength.toLongLong() > MAX_ENTRY_SIZE) {
+        return false;
+    }
+
+    entry.etag = reply.rawHeader("ETag");
+    entry.lastModified = reply.rawHeader("Last-Modified");
+    entry.expires = parseExpires(reply);
+    return entry.isFresh() || entry.hasValidators();
+}
+
+QString HttpCache::diskFileName(const QString &key) const {
+    return QString(QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex());
+}
+
+bool HttpCache::find(const QString &key, Entry &entry) {
+    const auto found = memoryIndex.find(key.toStdString());
+    if (found != memoryIndex.end()) {
+        memory.splice(memory.begin(), memory, found->second);
+        entry = found->second->second;
+        return true;
+    }
+    if (!findDisk(key, entry)) {
+        return false;
+    }
+    insertMemory(key, entry);
+    return true;
+}
+
+void HttpCache::insert(const QString &key, const Entry &entry) {
+    if (entry.body.size() > MAX_ENTRY_SIZE) {
+        return;
+    }
+    insertMemory(key, entry);
+    diskThread.post([this, key, entry]{
+        try {
+            insertDisk(key, entry);
+        } catch (const Exception &e) {
+            LOG << "Http cache: not saved " << key << ": " << e;
+        } catch (...) {
+            LOG << "Http cache: not saved " << key << ": unknown error";
+        }
+    });
+}
+
+void HttpCache::insertMemory(const QString &key, const Entry &entry) {
+    const std::string keyStr = key.toStdString();
+    const auto found = memoryIndex.find(keyStr);
+    if (found != memoryIndex.end()) {
+        memorySize -= found->second->second.body.size();
+        memory.erase(found->second);
+        memoryIndex.erase(found);
+    }
+
+    memory.emplace_front(key, entry);
+    memoryIndex[keyStr] = memory.begin();
+    memorySize += entry.body.size();
+
+    while (memorySize > maxMemorySize && memory.size() > 1) {
+        const auto &last = memory.back();
+        memorySize -= last.second.body.size();
+        memoryIndex.erase(last.first.toStdString());
+        memory.pop_back();
+    }
+}
+
+void HttpCache::loadDisk() {
+    // Новые файлы в начале списка, как и при записи
+    const QFileInfoList files = QDir(diskPath).entryInfoList(QDir::Files, QDir::Time);
+    std::lock_guard<std::mutex> lock(diskMut);
+    for (const QFileInfo &file: files) {
+        if (file.fileName().endsWith(TMP_SUFFIX)) {
+            // Недописанная запись с прошлого запуска
+            removeFile(file.absoluteFilePath());
+            continue;
+        }
+        const std::string name = file.fileName().toStdString();
+        if (diskIndex.find(name) != diskIndex.end()) {
+            continue;
+        }
+        diskFiles.push_back(DiskFile{file.fileName(), size_t(file.size())});
+        diskIndex[name] = std::prev(diskFiles.end());
+        diskSize += file.size();
+    }
+    isDiskLoaded = true;
+}
+
+void HttpCache::insertDisk(const QString &key, const Entry &entry) {
+    const QString fileName = diskFileName(key);
+    const QString filePath = makePath(diskPath, fileName);
+    // Через временный файл, чтобы findDisk не прочитал запись наполовину
+    const QString tmpPath = filePath + TMP_SUFFIX;
+    QFile file(tmpPath);
+    CHECK(file.open(QIODevice::WriteOnly), "Not open file " + tmpPath.toStdString());
+    QDataStream stream(&file);
+    stream << DISK_FORMAT_VERSION << key << entry.mime << entry.etag << entry.lastModified << qint64(systemTimePointToInt(entry.expires)) << entry.body;
+    CHECK(stream.status() == QDataStream::Ok, "Error write file " + tmpPath.toStdString());
+    file.close();
+    const size_t size = QFileInfo(tmpPath).size();
+    removeFile(filePath);
+    CHECK(QFile::rename(tmpPath, filePath), "Not rename file " + tmpPath.toStdString());
+
+    std::vector<QString> evicted;
+    {
+        std::lock_guard<std::mutex> lock(diskMut);
+        const std::string name = fileName.toStdString();
+        const auto found = diskIndex.find(name);
+        if (found != diskIndex.end()) {
+            diskSize -= std::min(diskSize, found->second->size);
+            diskFiles.erase(found->second);
+            diskIndex.erase(found);
+        }
+        diskFiles.push_front(DiskFile{fileName, size});
+        diskIndex[name] = diskFiles.begin();
+        diskSize += size;
+
+        while (diskSize > maxDiskSize && diskFiles.size() > 1) {
+            const DiskFile &last = diskFiles.back();
+            diskSize -= std::min(diskSize, last.size);
+            diskIndex.erase(last.name.toStdString());
+            evicted.emplace_back(last.name);
+            diskFiles.pop_back();
+        }
+    }
+    for (const QString &name: evicted) {
+        removeFile(makePath(diskPath, name));
+    }
+}
+
+bool HttpCache::findDisk(const QString &key, Entry &entry) {
+    const QString fileName = diskFileName(key);
+    {
+        std::lock_guard<std::mutex> lock(diskMut);
+        if (isDiskLoaded && diskIndex.find(fileName.toStdString()) == diskIndex.end()) {
+            return false;
+        }
+    }
+    QFile file(makePath(diskPath, fileName));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream stream(&file);
+    quint32 version;
+    QString storedKey;
+    qint64 expires;
+    stream >> version;
+    if (version != DISK_FORMAT_VERSION) {
+        return false;
+    }
+    stream >> storedKey >> entry.mime >> entry.etag >> entry.lastModified >> expires >> entry.body;
+    if (stream.status() != QDataStream::Ok || storedKey != key) {
+        return false;
+    }
+    entry.expires = intToSystemTimePoint(expires);
+    return true;
+}
@@ -0,0 +1,107 @@
+#ifndef HTTPCACHE_H
+#define HTTPCACHE_H
+
+#include <list>
+#include <unordered_map>
+#include <string>
+#include <mutex>
+
+#include <QString>
+#include <QByteArray>
+
+#include "duration.h"
+#include "ThreadPool.h"
+
+class QNetworkReply;
+
+/*
+   Кэш ответов по ключу (host, path) в памяти и на диске. Оба уровня ограничены по размеру,
+   в памяти вытесняются давно не использованные записи, на диске - давно записанные.
+   Запись на диск, вытеснение и начальный обход папки идут в отдельном потоке, поток вызова только
+   сверяется с индексом файлов в памяти.
+   */
+class HttpCache {
+public:
+
+    struct Entry {
+        QByteArray mime;
+        QByteArray body;
+        QByteArray etag;
+        QByteArray lastModified;
+        system_time_point expires;
+
+        bool isFresh() const;
+
+        bool hasValidators() const;
+    };
+
+public:
+
+    HttpCache(const QString &diskPath, size_t maxMemorySize, size_t maxDiskSize);
+
+    ~HttpCache();
+
+    static QString makeKey(const QString &host, const QString &pathAndQuery);
+
+    // Заполняет заголовочную часть entry по ответу. false, если ответ кэшировать нельзя (no-store, Vary и т.п.)
+    static bool parseResponse(QNetworkReply &reply, Entry &entry);
+
+    // Срок жизни по Cache-Control: max-age или Expires. Без них ответ каждый раз перепроверяется
+    static system_time_point parseExpires(QNetworkReply &reply);
+
+    bool find(const QString &key, Entry &entry);
+
+    void insert(const QString &key, const Entry &entry);
+
+private:
+
+    using MemoryList = std::list<std::pair<QString, Entry>>;
+
+    struct DiskFile {
+        QString name;
+        size_t size;
+    };
+
+    // Свежие записи в начале
+    using DiskList = std::list<DiskFile>;
+
+    void insertMemory(const QString &key, const Entry &entry);
+
+    void loadDisk();
+
+    void insertDisk(const QString &key, const Entry &entry);
+
+    bool findDisk(const QString &key, Entry &entry);
+
+    QString diskFileName(const QString &key) const;
+
+private:
+
+    const QString diskPath;
+
+    const size_t maxMemorySize;
+
+    const size_t maxDiskSize;
+
+    MemoryList memory;
+
+    std::unordered_map<std::string, MemoryList::iterator> memoryIndex;
+
+    size_t memorySize = 0;
+
+    std::mutex diskMut;
+
+    DiskList diskFiles;
+
+    std::unordered_map<std::string, DiskList::iterator> diskIndex;
+
+    size_t diskSize = 0;
+
+    // Пока папка не обойдена, отсутствие в индексе еще ничего не значит
+    bool isDiskLoaded = false;
+
+    // Один поток, поэтому операции с диском идут строго по очереди. Объявлен последним и разрушается первым
+    ThreadPool diskThread;
+};
+
+#endif // HTTPCACHE_H
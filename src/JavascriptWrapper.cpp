@@ -44,6 +44,16 @@ const static QString WALLET_PATH_MTH = "mhc/";
 const static QString WALLET_PATH_TMH_OLD = "mth/";
 const static QString WALLET_PATH_TMH = "tmh/";
 
+const static milliseconds KEY_SESSIONS_CHECK_PERIOD = 5s;
+
+// Подписи и генерация ключей сами распараллеливают scrypt на общем пуле, поэтому потоков для задач немного
+const static size_t JOB_THREADS = 2;
+
+// Задачи с одним кошельком выполняются по очереди
+static std::string makeJobKey(const QString &walletPath, const std::string &address) {
+    return walletPath.toStdString() + "/" + address;
+}
+
 static QString makeCommandLineMessageForWss(const QString &hardwareId, const QString &userId, size_t focusCount, const QString &line, bool isEnter, bool isUserText) {
     QJsonObject allJson;
     allJson.insert("app", "MetaSearch");
@@ -91,6 +101,7 @@ JavascriptWrapper::JavascriptWrapper(WebSocketClient &wssClient, NsLookup &nsLoo
     : wssClient(wssClient)
     , nsLookup(nsLookup)
     , applicationVersion(applicationVersion)
+    , jobs(JOB_THREADS)
 {
     hardwareId = QString::fromStdString(::getMachineUid());
 
@@ -103,12 +114,17 @@ JavascriptWrapper::JavascriptWrapper(WebSocketClient &wssClient, NsLookup &nsLoo
 
     CHECK(connect(&client, SIGNAL(callbackCall(ReturnCallback)), this, SLOT(onCallbackCall(ReturnCallback))), "not connect callbackCall");
 
+    CHECK(connect(&jobs, &JobExecutor::callbackCall, this, &JavascriptWrapper::onCallbackCall), "not connect jobs callbackCall");
+
     CHECK(connect(&fileSystemWatcher, SIGNAL(directoryChanged(const QString&)), this, SLOT(onDirChanged(const QString&))), "not connect fileSystemWatcher");
 
     CHECK(connect(&wssClient, &WebSocketClient::messageReceived, this, &JavascriptWrapper::onWssMessageReceived), "not connect wssClient");
 
     CHECK(connect(this, &JavascriptWrapper::sendCommandLineMessageToWssSig, this, &JavascriptWrapper::onSendCommandLineMessageToWss), "not connect onSendCommandLineMessageToWss");
 
+    CHECK(connect(&keySessionsTimer, &QTimer::timeout, this, &JavascriptWrapper::onKeySessionsTimer), "not connect keySessionsTimer");
+    keySessionsTimer.start(KEY_SESSIONS_CHECK_PERIOD.count());
+
     sendAppInfoToWss("", true);
 }
 
@@ -158,10 +174,10 @@ void JavascriptWrapper::sendAppInfoToWss(QString userName, bool force) {
     const QString newUserName = userName;
     if (force || newUserName != sendedUserName) {
         std::vector<QString> keysTmh;
-        const std::vector<std::pair<QString, QString>> keys1 = Wallet::getAllWalletsInFolder(walletPathTmh);
+        const std::vector<std::pair<QString, QString>> &keys1 = walletsInventory.getWallets(walletPathTmh);
         std::transform(keys1.begin(), keys1.end(), std::back_inserter(keysTmh), [](const auto &pair) {return pair.first;});
         std::vector<QString> keysMth;
-        const std::vector<std::pair<QString, QString>> keys2 = Wallet::getAllWalletsInFolder(walletPathMth);
+        const std::vector<std::pair<QString, QString>> &keys2 = walletsInventory.getWallets(walletPathMth);
         std::transform(keys2.begin(), keys2.end(), std::back_inserter(keysMth), [](const auto &pair) {return pair.first;});
 
         const QString message = makeMessageApplicationForWss(hardwareId, newUserName, applicationVersion, lastHtmls.lastVersion, keysTmh, keysMth);
@@ -208,6 +224,7 @@ void JavascriptWrapper::createWalletMTHS(QString requestId, QString password, QS
 
         walletFullPath = wallet.getFullPath();
     });
+    walletsInventory.update(walletPath);
 
     makeAndRunJsFuncParams(jsNameResult, walletFullPath.getWithoutCheck(), exception, Opt<QString>(requestId), publicKey, address, exampleMessage, signature);
 }
@@ -258,6 +275,18 @@ BEGIN_SLOT_WRAPPER
 END_SLOT_WRAPPER
 }
 
+void JavascriptWrapper::signMessagesBatch(QString requestId, QString keyName, QString password, QString jsonTxs) {
+BEGIN_SLOT_WRAPPER
+    signMessagesBatchMTHS(requestId, keyName, password, jsonTxs, walletPathTmh, "signMessagesBatchResultJs");
+END_SLOT_WRAPPER
+}
+
+void JavascriptWrapper::signMessagesBatchMHC(QString requestId, QString keyName, QString password, QString jsonTxs) {
+BEGIN_SLOT_WRAPPER
+    signMessagesBatchMTHS(requestId, keyName, password, jsonTxs, walletPathMth, "signMessagesBatchMHCResultJs");
+END_SLOT_WRAPPER
+}
+
 void JavascriptWrapper::signMessageMHCDelegate(QString requestId, QString keyName, QString password, QString toAddress, QString value, QString fee, QString nonce, QString valueDelegate, bool isDelegate) {
 BEGIN_SLOT_WRAPPER
     signMessageDelegateMTHS(requestId, keyName, password, toAddress, value, fee, nonce, valueDelegate, isDelegate, walletPathMth, "signMessageDelegateResultJs");
@@ -300,9 +329,9 @@ static QString makeJsonWalletsAndPaths(const std::vector<std::pair<QString, QStr
 QString JavascriptWrapper::getAllMTHSWalletsAndPathsJson(QString walletPath) {
     try {
         CHECK(!walletPath.isNull() && !walletPath.isEmpty(), "Incorrect path to wallet: empty");
-        const std::vector<std::pair<QString, QString>> result = Wallet::getAllWalletsInFolder(walletPath);
+        const std::vector<std::pair<QString, QString>> &result = walletsInventory.getWallets(walletPath);
         const QString jsonStr = makeJsonWalletsAndPaths(result);
-        LOG << "get mth wallets json " << jsonStr;
+        LOG_DEBUG << "get mth wallets json " << jsonStr;
         return jsonStr;
     } catch (const Exception &e) {
         LOG << "Error: " + e;
@@ -316,9 +345,9 @@ QString JavascriptWrapper::getAllMTHSWalletsAndPathsJson(QString walletPath) {
 QString JavascriptWrapper::getAllMTHSWalletsJson(QString walletPath) {
     try {
         CHECK(!walletPath.isNull() && !walletPath.isEmpty(), "Incorrect path to wallet: empty");
-        const std::vector<std::pair<QString, QString>> result = Wallet::getAllWalletsInFolder(walletPath);
+        const std::vector<std::pair<QString, QString>> &result = walletsInventory.getWallets(walletPath);
         const QString jsonStr = makeJsonWallets(result);
-        LOG << "get mth wallets json " << jsonStr;
+        LOG_DEBUG << "get mth wallets json " << jsonStr;
         return jsonStr;
     } catch (const Exception &e) {
         LOG << "Error: " + e;
@@ -359,7 +388,7 @@ void JavascriptWrapper::signMessageMTHS(QString requestId, QString keyName, QStr
     Opt<std::string> publicKey;
     const TypedException exception = apiVrapper2([&, this]() {
         CHECK(!walletPath.isNull() && !walletPath.isEmpty(), "Incorrect path to wallet: empty");
-        Wallet wallet(walletPath, keyName.toStdString(), password.toStdString());
+        Wallet wallet = openWalletMTHS(walletPath, keyName.toStdString(), password.toStdString());
         std::string pubKey;
         signature = wallet.sign(textStr, pubKey);
         publicKey = pubKey;
@@ -376,7 +405,7 @@ void JavascriptWrapper::signMessageMTHS(QString requestId, QString keyName, QStr
     Opt<std::string> signature2;
     const TypedException exception = apiVrapper2([&, this]() {
         CHECK(!walletPath.isNull() && !walletPath.isEmpty(), "Incorrect path to wallet: empty");
-        Wallet wallet(walletPath, keyName.toStdString(), password.toStdString());
+        Wallet wallet = openWalletMTHS(walletPath, keyName.toStdString(), password.toStdString());
         std::string publicKey;
         std::string tx;
         std::string signature;
@@ -398,7 +427,7 @@ void JavascriptWrapper::signMessageDelegateMTHS(QString requestId, QString keyNa
     Opt<std::string> signature2;
     const TypedException exception = apiVrapper2([&, this]() {
         CHECK(!walletPath.isNull() && !walletPath.isEmpty(), "Incorrect path to wallet: empty");
-        Wallet wallet(walletPath, keyName.toStdString(), password.toStdString());
+        Wallet wallet = openWalletMTHS(walletPath, keyName.toStdString(), password.toStdString());
 
         const uint64_t delegValue = std::stoull(valueDelegate.toStdString());
         const std::string dataHex = Wallet::genDataDelegateHex(isDelegate, delegValue);
@@ -416,6 +445,63 @@ void JavascriptWrapper::signMessageDelegateMTHS(QString requestId, QString keyNa
     makeAndRunJsFuncParams(jsNameResult, exception, Opt<QString>(requestId), signature2, publicKey2, tx2);
 }
 
+static uint64_t parseBatchNumber(const QJsonObject &jsonObj, const QString &field) {
+    CHECK_TYPED(jsonObj.contains(field) && jsonObj.value(field).isString(), TypeErrors::INCORRECT_USER_DATA, field.toStdString() + " field not found");
+    const std::string value = jsonObj.value(field).toString().toStdString();
+    CHECK_TYPED(!value.empty() && isDecimal(value), TypeErrors::INCORRECT_USER_DATA, "Not decimal number " + field.toStdString());
+    bool isOk;
+    const uint64_t result = QString::fromStdString(value).toULongLong(&isOk, 10);
+    CHECK_TYPED(isOk, TypeErrors::INCORRECT_USER_DATA, "Incorrect number " + field.toStdString());
+    return result;
+}
+
+void JavascriptWrapper::signMessagesBatchMTHS(QString requestId, QString keyName, QString password, QString jsonTxs, QString walletPath, QString jsNameResult) {
+    LOG << "Sign messages batch " << requestId << " " << keyName;
+
+    Opt<std::string> publicKey2;
+    Opt<QJsonDocument> result;
+    const TypedException exception = apiVrapper2([&, this]() {
+        CHECK(!walletPath.isNull() && !walletPath.isEmpty(), "Incorrect path to wallet: empty");
+
+        std::vector<Wallet::TxParams> txs;
+        const QJsonDocument document = QJsonDocument::fromJson(jsonTxs.toUtf8());
+        CHECK_TYPED(document.isArray(), TypeErrors::INCORRECT_USER_DATA, "jsonTxs not array");
+        const QJsonArray root = document.array();
+        for (const auto &jsonObj2: root) {
+            CHECK_TYPED(jsonObj2.isObject(), TypeErrors::INCORRECT_USER_DATA, "transaction not object");
+            const QJsonObject jsonObj = jsonObj2.toObject();
+            Wallet::TxParams tx;
+            CHECK_TYPED(jsonObj.contains("to") && jsonObj.value("to").isString(), TypeErrors::INCORRECT_USER_DATA, "to field not found");
+            tx.toAddress = jsonObj.value("to").toString().toStdString();
+            tx.value = parseBatchNumber(jsonObj, "value");
+            tx.fee = parseBatchNumber(jsonObj, "fee");
+            tx.nonce = parseBatchNumber(jsonObj, "nonce");
+            if (jsonObj.contains("data")) {
+                CHECK_TYPED(jsonObj.value("data").isString(), TypeErrors::INCORRECT_USER_DATA, "data field incorrect");
+                tx.dataHex = jsonObj.value("data").toString().toStdString();
+            }
+            txs.emplace_back(tx);
+        }
+
+        const Wallet wallet = openWalletMTHS(walletPath, keyName.toStdString(), password.toStdString());
+        std::string publicKey;
+        const std::vector<Wallet::SignedTx> signedTxs = wallet.signBatch(txs, publicKey);
+
+        QJsonArray jsonArray;
+        for (const Wallet::SignedTx &signedTx: signedTxs) {
+            QJsonObject val;
+            val.insert("tx", QString::fromStdString(signedTx.txHex));
+            val.insert("signature", QString::fromStdString(signedTx.signature));
+            jsonArray.push_back(val);
+        }
+        publicKey2 = publicKey;
+        result = QJsonDocument(jsonArray);
+        LOG << "Signed batch " << signedTxs.size();
+    });
+
+    makeAndRunJsFuncParams(jsNameResult, exception, Opt<QString>(requestId), publicKey2, result);
+}
+
 void JavascriptWrapper::getOnePrivateKeyMTHS(QString requestId, QString keyName, bool isCompact, QString walletPath, QString jsNameResult, bool isTmh) {
     Opt<QString> result;
     const TypedException exception = apiVrapper2([&, this]() {
@@ -457,6 +543,7 @@ void JavascriptWrapper::savePrivateKeyMTHS(QString requestId, QString privateKey
         Wallet::savePrivateKey(walletPath, privateKey.toStdString(), password.toStdString());
         result = "ok";
     });
+    walletsInventory.update(walletPath);
 
     if (exception.numError != TypeErrors::NOT_ERROR) {
         result = "Not ok";
@@ -483,14 +570,19 @@ BEGIN_SLOT_WRAPPER
     LOG << "Create rsa key " << address;
 
     const QString JS_NAME_RESULT = "createRsaKeyResultJs";
-    Opt<std::string> publicKey;
-    const TypedException exception = apiVrapper2([&, this]() {
-        CHECK(!walletPathMth.isNull() && !walletPathMth.isEmpty(), "Incorrect path to wallet: empty");
-        Wallet::createRsaKey(walletPathMth, address.toStdString(), password.toStdString());
-        publicKey = Wallet::getPublicRsaKey(walletPathMth, address.toStdString());
-    });
+    const QString walletPath = walletPathMth;
+    jobs.run(makeJobKey(walletPath, address.toStdString()), [=]() -> ReturnCallback {
+        Opt<std::string> publicKey;
+        const TypedException exception = apiVrapper2([&]() {
+            CHECK(!walletPath.isNull() && !walletPath.isEmpty(), "Incorrect path to wallet: empty");
+            Wallet::createRsaKey(walletPath, address.toStdString(), password.toStdString());
+            publicKey = Wallet::getPublicRsaKey(walletPath, address.toStdString());
+        });
 
-    makeAndRunJsFuncParams(JS_NAME_RESULT, exception, Opt<QString>(requestId), publicKey);
+        return [=]{
+            makeAndRunJsFuncParams(JS_NAME_RESULT, exception, Opt<QString>(requestId), publicKey);
+        };
+    });
 END_SLOT_WRAPPER
 }
 
@@ -529,13 +621,18 @@ BEGIN_SLOT_WRAPPER
     LOG << "decrypt message " << addr;
 
     const QString JS_NAME_RESULT = "decryptMessageResultJs";
-    Opt<std::string> message;
-    const TypedException exception = apiVrapper2([&, this]() {
-        CHECK(!walletPathMth.isNull() && !walletPathMth.isEmpty(), "Incorrect path to wallet: empty");
-        message = Wallet::decryptMessage(walletPathMth, addr.toStdString(), password.toStdString(), encryptedMessageHex.toStdString());
-    });
+    const QString walletPath = walletPathMth;
+    jobs.run(makeJobKey(walletPath, addr.toStdString()), [=]() -> ReturnCallback {
+        Opt<std::string> message;
+        const TypedException exception = apiVrapper2([&]() {
+            CHECK(!walletPath.isNull() && !walletPath.isEmpty(), "Incorrect path to wallet: empty");
+            message = Wallet::decryptMessage(walletPath, addr.toStdString(), password.toStdString(), encryptedMessageHex.toStdString());
+        });
 
-    makeAndRunJsFuncParams(JS_NAME_RESULT, exception, Opt<QString>(requestId), message);
+        return [=]{
+            makeAndRunJsFuncParams(JS_NAME_RESULT, exception, Opt<QString>(requestId), message);
+        };
+    });
 END_SLOT_WRAPPER
 }
 
@@ -557,6 +654,7 @@ BEGIN_SLOT_WRAPPER
         fullPath = EthWallet::getFullPath(walletPathEth, address.get());
         LOG << "Create eth wallet ok " << requestId << " " << address.get();
     });
+    walletsInventory.update(walletPathEth);
 
     makeAndRunJsFuncParams(JS_NAME_RESULT, fullPath, exception, Opt<QString>(requestId), address);
 END_SLOT_WRAPPER
@@ -568,21 +666,26 @@ BEGIN_SLOT_WRAPPER
 
     LOG << "Sign message eth " << address << " " << nonce << " " << gasPrice << " " << gasLimit << " " << to << " " << value << " " << data;
 
-    Opt<std::string> result;
-    const TypedException exception = apiVrapper2([&, this]() {
-        CHECK(!walletPathEth.isNull() && !walletPathEth.isEmpty(), "Incorrect path to wallet: empty");
-        EthWallet wallet(walletPathEth, address.toStdString(), password.toStdString());
-        result = wallet.SignTransaction(
-            nonce.toStdString(),
-            gasPrice.toStdString(),
-            gasLimit.toStdString(),
-            to.toStdString(),
-            value.toStdString(),
-            data.toStdString()
-        );
-    });
+    const QString walletPath = walletPathEth;
+    jobs.run(makeJobKey(walletPath, toLower(address.toStdString())), [=]() -> ReturnCallback {
+        Opt<std::string> result;
+        const TypedException exception = apiVrapper2([&]() {
+            CHECK(!walletPath.isNull() && !walletPath.isEmpty(), "Incorrect path to wallet: empty");
+            EthWallet wallet = openWalletEth(walletPath, address.toStdString(), password.toStdString());
+            result = wallet.SignTransaction(
+                nonce.toStdString(),
+                gasPrice.toStdString(),
+                gasLimit.toStdString(),
+                to.toStdString(),
+                value.toStdString(),
+                data.toStdString()
+            );
+        });
 
-    makeAndRunJsFuncParams(JS_NAME_RESULT, exception, Opt<QString>(requestId), result);
+        return [=]{
+            makeAndRunJsFuncParams(JS_NAME_RESULT, exception, Opt<QString>(requestId), result);
+        };
+    });
 END_SLOT_WRAPPER
 }
 
@@ -632,9 +735,9 @@ END_SLOT_WRAPPER
 QString JavascriptWrapper::getAllEthWalletsJson() {
     try {
         CHECK(!walletPathEth.isNull() && !walletPathEth.isEmpty(), "Incorrect path to wallet: empty");
-        const std::vector<std::pair<QString, QString>> result = EthWallet::getAllWalletsInFolder(walletPathEth);
+        const std::vector<std::pair<QString, QString>> &result = walletsInventory.getWallets(walletPathEth);
         const QString jsonStr = makeJsonWallets(result);
-        LOG << "get eth wallets json " << jsonStr;
+        LOG_DEBUG << "get eth wallets json " << jsonStr;
         return jsonStr;
     } catch (const Exception &e) {
         LOG << "Error: " + e;
@@ -648,9 +751,9 @@ QString JavascriptWrapper::getAllEthWalletsJson() {
 QString JavascriptWrapper::getAllEthWalletsAndPathsJson() {
     try {
         CHECK(!walletPathEth.isNull() && !walletPathEth.isEmpty(), "Incorrect path to wallet: empty");
-        const std::vector<std::pair<QString, QString>> result = EthWallet::getAllWalletsInFolder(walletPathEth);
+        const std::vector<std::pair<QString, QString>> &result = walletsInventory.getWallets(walletPathEth);
         const QString jsonStr = makeJsonWalletsAndPaths(result);
-        LOG << "get eth wallets json " << jsonStr;
+        LOG_DEBUG << "get eth wallets json " << jsonStr;
         return jsonStr;
     } catch (const Exception &e) {
         LOG << "Error: " + e;
@@ -696,6 +799,7 @@ BEGIN_SLOT_WRAPPER
         EthWallet::savePrivateKey(walletPathEth, privateKey.toStdString(), password.toStdString());
         result = "ok";
     });
+    walletsInventory.update(walletPathEth);
 
     if (exception.numError != TypeErrors::NOT_ERROR) {
         result = "Not ok";
@@ -714,17 +818,23 @@ BEGIN_SLOT_WRAPPER
 
     LOG << "Create wallet btc " << requestId;
 
-    Opt<std::string> address;
-    QString fullPath;
-    const TypedException exception = apiVrapper2([&, this]() {
-        CHECK(!walletPathBtc.isNull() && !walletPathBtc.isEmpty(), "Incorrect path to wallet: empty");
-        address = BtcWallet::genPrivateKey(walletPathBtc, password).first;
+    const QString walletPath = walletPathBtc;
+    jobs.run(makeJobKey(walletPath, ""), [=]() -> ReturnCallback {
+        Opt<std::string> address;
+        QString fullPath;
+        const TypedException exception = apiVrapper2([&]() {
+            CHECK(!walletPath.isNull() && !walletPath.isEmpty(), "Incorrect path to wallet: empty");
+            address = BtcWallet::genPrivateKey(walletPath, password).first;
 
-        fullPath = BtcWallet::getFullPath(walletPathBtc, address.get());
-        LOG << "Create btc wallet ok " << requestId << " " << address.get();
-    });
+            fullPath = BtcWallet::getFullPath(walletPath, address.get());
+            LOG << "Create btc wallet ok " << requestId << " " << address.get();
+        });
 
-    makeAndRunJsFuncParams(JS_NAME_RESULT, fullPath, exception, Opt<QString>(requestId), address);
+        return [=]{
+            walletsInventory.update(walletPath);
+            makeAndRunJsFuncParams(JS_NAME_RESULT, fullPath, exception, Opt<QString>(requestId), address);
+        };
+    });
 END_SLOT_WRAPPER
 }
 
@@ -763,39 +873,44 @@ BEGIN_SLOT_WRAPPER
 
     LOG << "Sign message btc " << address << " " << toAddress << " " << value << " " << estimateComissionInSatoshi << " " << fees;
 
-    Opt<std::string> result;
-    const TypedException exception = apiVrapper2([&, this]() {
-        std::vector<BtcInput> btcInputs;
+    const QString walletPath = walletPathBtc;
+    jobs.run(makeJobKey(walletPath, address.toStdString()), [=]() -> ReturnCallback {
+        Opt<std::string> result;
+        const TypedException exception = apiVrapper2([&]() {
+            std::vector<BtcInput> btcInputs;
+
+            const QJsonDocument document = QJsonDocument::fromJson(jsonInputs.toUtf8());
+            CHECK(document.isArray(), "jsonInputs not array");
+            const QJsonArray root = document.array();
+            for (const auto &jsonObj2: root) {
+                const QJsonObject jsonObj = jsonObj2.toObject();
+                BtcInput input;
+                CHECK(jsonObj.contains("value") && jsonObj.value("value").isString(), "value field not found");
+                input.outBalance = std::stoull(jsonObj.value("value").toString().toStdString());
+                CHECK(jsonObj.contains("scriptPubKey") && jsonObj.value("scriptPubKey").isString(), "scriptPubKey field not found");
+                input.scriptPubkey = jsonObj.value("scriptPubKey").toString().toStdString();
+                CHECK(jsonObj.contains("tx_index") && jsonObj.value("tx_index").isDouble(), "tx_index field not found");
+                input.spendoutnum = jsonObj.value("tx_index").toInt();
+                CHECK(jsonObj.contains("tx_hash") && jsonObj.value("tx_hash").isString(), "tx_hash field not found");
+                input.spendtxid = jsonObj.value("tx_hash").toString().toStdString();
+                btcInputs.emplace_back(input);
+            }
 
-        const QJsonDocument document = QJsonDocument::fromJson(jsonInputs.toUtf8());
-        CHECK(document.isArray(), "jsonInputs not array");
-        const QJsonArray root = document.array();
-        for (const auto &jsonObj2: root) {
-            const QJsonObject jsonObj = jsonObj2.toObject();
-            BtcInput input;
-            CHECK(jsonObj.contains("value") && jsonObj.value("value").isString(), "value field not found");
-            input.outBalance = std::stoull(jsonObj.value("value").toString().toStdString());
-            CHECK(jsonObj.contains("scriptPubKey") && jsonObj.value("scriptPubKey").isString(), "scriptPubKey field not found");
-            input.scriptPubkey = jsonObj.value("scriptPubKey").toString().toStdString();
-            CHECK(jsonObj.contains("tx_index") && jsonObj.value("tx_index").isDouble(), "tx_index field not found");
-            input.spendoutnum = jsonObj.value("tx_index").toInt();
-            CHECK(jsonObj.contains("tx_hash") && jsonObj.value("tx_hash").isString(), "tx_hash field not found");
-            input.spendtxid = jsonObj.value("tx_hash").toString().toStdString();
-            btcInputs.emplace_back(input);
-        }
+            CHECK(!walletPath.isNull() && !walletPath.isEmpty(), "Incorrect path to wallet: empty");
+            BtcWallet wallet = openWalletBtc(walletPath, address.toStdString(), password);
+            size_t estimateComissionInSatoshiInt = 0;
+            if (!estimateComissionInSatoshi.isEmpty()) {
+                CHECK(isDecimal(estimateComissionInSatoshi.toStdString()), "Not hex number value");
+                estimateComissionInSatoshiInt = std::stoll(estimateComissionInSatoshi.toStdString());
+            }
+            const auto resultPair = wallet.buildTransaction(btcInputs, estimateComissionInSatoshiInt, value.toStdString(), fees.toStdString(), toAddress.toStdString());
+            result = resultPair.first;
+        });
 
-        CHECK(!walletPathBtc.isNull() && !walletPathBtc.isEmpty(), "Incorrect path to wallet: empty");
-        BtcWallet wallet(walletPathBtc, address.toStdString(), password);
-        size_t estimateComissionInSatoshiInt = 0;
-        if (!estimateComissionInSatoshi.isEmpty()) {
-            CHECK(isDecimal(estimateComissionInSatoshi.toStdString()), "Not hex number value");
-            estimateComissionInSatoshiInt = std::stoll(estimateComissionInSatoshi.toStdString());
-        }
-        const auto resultPair = wallet.buildTransaction(btcInputs, estimateComissionInSatoshiInt, value.toStdString(), fees.toStdString(), toAddress.toStdString());
-        result = resultPair.first;
+        return [=]{
+            makeAndRunJsFuncParams(JS_NAME_RESULT, exception, Opt<QString>(requestId), result);
+        };
     });
-
-    makeAndRunJsFuncParams(JS_NAME_RESULT, exception, Opt<QString>(requestId), result);
 END_SLOT_WRAPPER
 }
 
@@ -805,62 +920,67 @@ BEGIN_SLOT_WRAPPER
 
     LOG << "Sign message btc utxos " << address << " " << toAddress << " " << value << " " << estimateComissionInSatoshi << " " << fees;
 
-    Opt<QJsonDocument> jsonUtxos;
-    Opt<std::string> transactionHash;
-    Opt<std::string> result;
-    const TypedException exception = apiVrapper2([&, this]() {
-        std::vector<BtcInput> btcInputs;
-
-        const QJsonDocument document = QJsonDocument::fromJson(jsonInputs.toUtf8());
-        CHECK(document.isArray(), "jsonInputs not array");
-        const QJsonArray root = document.array();
-        for (const auto &jsonObj2: root) {
-            const QJsonObject jsonObj = jsonObj2.toObject();
-            BtcInput input;
-            CHECK(jsonObj.contains("value") && jsonObj.value("value").isString(), "value field not found");
-            input.outBalance = std::stoull(jsonObj.value("value").toString().toStdString());
-            CHECK(jsonObj.contains("scriptPubKey") && jsonObj.value("scriptPubKey").isString(), "scriptPubKey field not found");
-            input.scriptPubkey = jsonObj.value("scriptPubKey").toString().toStdString();
-            CHECK(jsonObj.contains("tx_index") && jsonObj.value("tx_index").isDouble(), "tx_index field not found");
-            input.spendoutnum = jsonObj.value("tx_index").toInt();
-            CHECK(jsonObj.contains("tx_hash") && jsonObj.value("tx_hash").isString(), "tx_hash field not found");
-            input.spendtxid = jsonObj.value("tx_hash").toString().toStdString();
-            btcInputs.emplace_back(input);
-        }
+    const QString walletPath = walletPathBtc;
+    jobs.run(makeJobKey(walletPath, address.toStdString()), [=]() -> ReturnCallback {
+        Opt<QJsonDocument> jsonUtxos;
+        Opt<std::string> transactionHash;
+        Opt<std::string> result;
+        const TypedException exception = apiVrapper2([&]() {
+            std::vector<BtcInput> btcInputs;
+
+            const QJsonDocument document = QJsonDocument::fromJson(jsonInputs.toUtf8());
+            CHECK(document.isArray(), "jsonInputs not array");
+            const QJsonArray root = document.array();
+            for (const auto &jsonObj2: root) {
+                const QJsonObject jsonObj = jsonObj2.toObject();
+                BtcInput input;
+                CHECK(jsonObj.contains("value") && jsonObj.value("value").isString(), "value field not found");
+                input.outBalance = std::stoull(jsonObj.value("value").toString().toStdString());
+                CHECK(jsonObj.contains("scriptPubKey") && jsonObj.value("scriptPubKey").isString(), "scriptPubKey field not found");
+                input.scriptPubkey = jsonObj.value("scriptPubKey").toString().toStdString();
+                CHECK(jsonObj.contains("tx_index") && jsonObj.value("tx_index").isDouble(), "tx_index field not found");
+                input.spendoutnum = jsonObj.value("tx_index").toInt();
+                CHECK(jsonObj.contains("tx_hash") && jsonObj.value("tx_hash").isString(), "tx_hash field not found");
+                input.spendtxid = jsonObj.value("tx_hash").toString().toStdString();
+                btcInputs.emplace_back(input);
+            }
 
-        std::set<std::string> usedUtxos;
-        const QJsonDocument documentUsed = QJsonDocument::fromJson(jsonUsedUtxos.toUtf8());
-        CHECK(documentUsed.isArray(), "jsonInputs not array");
-        const QJsonArray rootUsed = documentUsed.array();
-        for (const auto &jsonUsedUtxo: rootUsed) {
-            CHECK(jsonUsedUtxo.isString(), "value field not found");
-            usedUtxos.insert(jsonUsedUtxo.toString().toStdString());
-        }
-        btcInputs = BtcWallet::reduceInputs(btcInputs, usedUtxos);
-        LOG << "Used utxos: " << usedUtxos.size();
+            std::set<std::string> usedUtxos;
+            const QJsonDocument documentUsed = QJsonDocument::fromJson(jsonUsedUtxos.toUtf8());
+            CHECK(documentUsed.isArray(), "jsonInputs not array");
+            const QJsonArray rootUsed = documentUsed.array();
+            for (const auto &jsonUsedUtxo: rootUsed) {
+                CHECK(jsonUsedUtxo.isString(), "value field not found");
+                usedUtxos.insert(jsonUsedUtxo.toString().toStdString());
+            }
+            btcInputs = BtcWallet::reduceInputs(btcInputs, usedUtxos);
+            LOG << "Used utxos: " << usedUtxos.size();
+
+            CHECK(!walletPath.isNull() && !walletPath.isEmpty(), "Incorrect path to wallet: empty");
+            BtcWallet wallet = openWalletBtc(walletPath, address.toStdString(), password);
+            size_t estimateComissionInSatoshiInt = 0;
+            if (!estimateComissionInSatoshi.isEmpty()) {
+                CHECK(isDecimal(estimateComissionInSatoshi.toStdString()), "Not hex number value");
+                estimateComissionInSatoshiInt = std::stoll(estimateComissionInSatoshi.toStdString());
+            }
+            const auto resultPair = wallet.buildTransaction(btcInputs, estimateComissionInSatoshiInt, value.toStdString(), fees.toStdString(), toAddress.toStdString());
+            result = resultPair.first;
+            const std::set<std::string> &thisUsedTxs = resultPair.second;
+            usedUtxos.insert(thisUsedTxs.begin(), thisUsedTxs.end());
+
+            QJsonArray jsonArrayUtxos;
+            for (const std::string &r: usedUtxos) {
+                jsonArrayUtxos.push_back(QString::fromStdString(r));
+            }
+            jsonUtxos = QJsonDocument(jsonArrayUtxos);
 
-        CHECK(!walletPathBtc.isNull() && !walletPathBtc.isEmpty(), "Incorrect path to wallet: empty");
-        BtcWallet wallet(walletPathBtc, address.toStdString(), password);
-        size_t estimateComissionInSatoshiInt = 0;
-        if (!estimateComissionInSatoshi.isEmpty()) {
-            CHECK(isDecimal(estimateComissionInSatoshi.toStdString()), "Not hex number value");
-            estimateComissionInSatoshiInt = std::stoll(estimateComissionInSatoshi.toStdString());
-        }
-        const auto resultPair = wallet.buildTransaction(btcInputs, estimateComissionInSatoshiInt, value.toStdString(), fees.toStdString(), toAddress.toStdString());
-        result = resultPair.first;
-        const std::set<std::string> &thisUsedTxs = resultPair.second;
-        usedUtxos.insert(thisUsedTxs.begin(), thisUsedTxs.end());
-
-        QJsonArray jsonArrayUtxos;
-        for (const std::string &r: usedUtxos) {
-            jsonArrayUtxos.push_back(QString::fromStdString(r));
-        }
-        jsonUtxos = QJsonDocument(jsonArrayUtxos);
+            transactionHash = BtcWallet::calcHashNotWitness(result.get());
+        });
 
-        transactionHash = BtcWallet::calcHashNotWitness(result.get());
+        return [=]{
+            makeAndRunJsFuncParams(JS_NAME_RESULT, exception, Opt<QString>(requestId), result, jsonUtxos, transactionHash);
+        };
     });
-
-    makeAndRunJsFuncParams(JS_NAME_RESULT, exception, Opt<QString>(requestId), result, jsonUtxos, transactionHash);
 END_SLOT_WRAPPER
 }
 
@@ -874,9 +994,9 @@ END_SLOT_WRAPPER
 QString JavascriptWrapper::getAllBtcWalletsJson() {
     try {
         CHECK(!walletPathBtc.isNull() && !walletPathBtc.isEmpty(), "Incorrect path to wallet: empty");
-        const std::vector<std::pair<QString, QString>> result = BtcWallet::getAllWalletsInFolder(walletPathBtc);
+        const std::vector<std::pair<QString, QString>> &result = walletsInventory.getWallets(walletPathBtc);
         const QString jsonStr = makeJsonWallets(result);
-        LOG << "get btc wallets json " << jsonStr;
+        LOG_DEBUG << "get btc wallets json " << jsonStr;
         return jsonStr;
     } catch (const Exception &e) {
         LOG << "Error: " + e;
@@ -890,9 +1010,9 @@ QString JavascriptWrapper::getAllBtcWalletsJson() {
 QString JavascriptWrapper::getAllBtcWalletsAndPathsJson() {
     try {
         CHECK(!walletPathBtc.isNull() && !walletPathBtc.isEmpty(), "Incorrect path to wallet: empty");
-        const std::vector<std::pair<QString, QString>> result = BtcWallet::getAllWalletsInFolder(walletPathBtc);
+        const std::vector<std::pair<QString, QString>> &result = walletsInventory.getWallets(walletPathBtc);
         const QString jsonStr = makeJsonWalletsAndPaths(result);
-        LOG << "get btc wallets json " << jsonStr;
+        LOG_DEBUG << "get btc wallets json " << jsonStr;
         return jsonStr;
     } catch (const Exception &e) {
         LOG << "Error: " + e;
@@ -937,6 +1057,7 @@ BEGIN_SLOT_WRAPPER
         BtcWallet::savePrivateKey(walletPathBtc, privateKey.toStdString(), password);
         result = "ok";
     });
+    walletsInventory.update(walletPathBtc);
 
     if (exception.numError != TypeErrors::NOT_ERROR) {
         result = "Not ok";
@@ -960,6 +1081,111 @@ BEGIN_SLOT_WRAPPER
 END_SLOT_WRAPPER
 }
 
+////////////////////
+/// KEY SESSIONS ///
+////////////////////
+
+Wallet JavascriptWrapper::openWalletMTHS(const QString &walletPath, const std::string &keyName, const std::string &password) {
+    SecureBytes privateKey;
+    if (keySessions.use(walletPath, keyName, password, privateKey)) {
+        return Wallet(walletPath, keyName, privateKey);
+    }
+    return Wallet(walletPath, keyName, password);
+}
+
+EthWallet JavascriptWrapper::openWalletEth(const QString &walletPath, const std::string &address, const std::string &password) {
+    SecureBytes privateKey;
+    if (keySessions.use(walletPath, toLower(address), password, privateKey)) {
+        return EthWallet(address, privateKey);
+    }
+    return EthWallet(walletPath, address, password);
+}
+
+BtcWallet JavascriptWrapper::openWalletBtc(const QString &walletPath, const std::string &address, const QString &password) {
+    SecureBytes wif;
+    if (keySessions.use(walletPath, address, password.toStdString(), wif)) {
+        return BtcWallet(address, wif);
+    }
+    return BtcWallet(walletPath, address, password);
+}
+
+QString JavascriptWrapper::getWalletPathForCurrency(const QString &currency) const {
+    if (currency == "tmh") {
+        return walletPathTmh;
+    } else if (currency == "mhc") {
+        return walletPathMth;
+    } else if (currency == "eth") {
+        return walletPathEth;
+    } else if (currency == "btc") {
+        return walletPathBtc;
+    } else {
+        throwErrTyped(TypeErrors::INCORRECT_USER_DATA, "Incorrect currency " + currency.toStdString());
+    }
+}
+
+void JavascriptWrapper::openKeySession(QString requestId, QString currency, QString address, QString password, int timeoutSeconds, int maxUses) {
+BEGIN_SLOT_WRAPPER
+    const QString JS_NAME_RESULT = "openKeySessionResultJs";
+
+    LOG << "Open key session " << currency << " " << address << " " << timeoutSeconds << " " << maxUses;
+
+    Opt<QString> result;
+    const TypedException exception = apiVrapper2([&, this]() {
+        const QString walletPath = getWalletPathForCurrency(currency);
+        CHECK(!walletPath.isNull() && !walletPath.isEmpty(), "Incorrect path to wallet: empty");
+        CHECK_TYPED(timeoutSeconds > 0 && maxUses > 0, TypeErrors::INCORRECT_USER_DATA, "Incorrect session limits");
+
+        const std::string addr = address.toStdString();
+        const std::string pass = password.toStdString();
+        const seconds timeout(timeoutSeconds);
+        if (currency == "eth") {
+            const EthWallet wallet(walletPath, addr, pass);
+            keySessions.open(walletPath, toLower(addr), pass, wallet.getRawPrivateKey(), timeout, maxUses);
+        } else if (currency == "btc") {
+            const BtcWallet wallet(walletPath, addr, password);
+            keySessions.open(walletPath, addr, pass, wallet.getDecryptedWif(), timeout, maxUses);
+        } else {
+            const Wallet wallet(walletPath, addr, pass);
+            keySessions.open(walletPath, addr, pass, wallet.getPrivateExponent(), timeout, maxUses);
+        }
+        result = "ok";
+    });
+
+    makeAndRunJsFuncParams(JS_NAME_RESULT, exception, Opt<QString>(requestId), result);
+END_SLOT_WRAPPER
+}
+
+void JavascriptWrapper::closeKeySession(QString requestId, QString currency, QString address) {
+BEGIN_SLOT_WRAPPER
+    const QString JS_NAME_RESULT = "closeKeySessionResultJs";
+
+    LOG << "Close key session " << currency << " " << address;
+
+    Opt<QString> result;
+    const TypedException exception = apiVrapper2([&, this]() {
+        const QString walletPath = getWalletPathForCurrency(currency);
+        const std::string addr = currency == "eth" ? toLower(address.toStdString()) : address.toStdString();
+        const bool isClosed = keySessions.close(walletPath, addr);
+        result = isClosed ? "ok" : "not found";
+    });
+
+    makeAndRunJsFuncParams(JS_NAME_RESULT, exception, Opt<QString>(requestId), result);
+END_SLOT_WRAPPER
+}
+
+void JavascriptWrapper::closeAllKeySessions() {
+BEGIN_SLOT_WRAPPER
+    LOG << "Close all key sessions";
+    keySessions.closeAll();
+END_SLOT_WRAPPER
+}
+
+void JavascriptWrapper::onKeySessionsTimer() {
+BEGIN_SLOT_WRAPPER
+    keySessions.removeExpired();
+END_SLOT_WRAPPER
+}
+
 //////////////
 /// COMMON ///
 //////////////
@@ -1029,22 +1255,26 @@ BEGIN_SLOT_WRAPPER
         CHECK(!walletPath.isNull() && !walletPath.isEmpty(), "Incorrect path to wallet: empty");
         createFolder(walletPath);
 
+        keySessions.closeAll();
+
         for (const FolderWalletInfo &folderInfo: folderWalletsInfos) {
             fileSystemWatcher.removePath(folderInfo.walletPath.absolutePath());
         }
         folderWalletsInfos.clear();
+        walletsInventory.clear();
 
-        auto setPathToWallet = [this](QString &curPath, const QString &suffix, const QString &name) {
+        auto setPathToWallet = [this](QString &curPath, const QString &suffix, const QString &name, const WalletsInventory::FileParser &parser) {
             curPath = makePath(walletPath, suffix);
             createFolder(curPath);
             folderWalletsInfos.emplace_back(curPath, name);
             fileSystemWatcher.addPath(curPath);
+            walletsInventory.addFolder(curPath, parser);
         };
 
-        setPathToWallet(walletPathEth, WALLET_PATH_ETH, "eth");
-        setPathToWallet(walletPathBtc, WALLET_PATH_BTC, "btc");
-        setPathToWallet(walletPathMth, WALLET_PATH_MTH, "mhc");
-        setPathToWallet(walletPathTmh, WALLET_PATH_TMH, "tmh");
+        setPathToWallet(walletPathEth, WALLET_PATH_ETH, "eth", &EthWallet::parseWalletFile);
+        setPathToWallet(walletPathBtc, WALLET_PATH_BTC, "btc", &BtcWallet::parseWalletFile);
+        setPathToWallet(walletPathMth, WALLET_PATH_MTH, "mhc", &Wallet::parseWalletFile);
+        setPathToWallet(walletPathTmh, WALLET_PATH_TMH, "tmh", &Wallet::parseWalletFile);
 
         walletPathOldTmh = makePath(walletPath, WALLET_PATH_TMH_OLD);
         LOG << "Wallets path " << walletPath;
@@ -1053,6 +1283,7 @@ BEGIN_SLOT_WRAPPER
         if (oldTmhPath.exists()) {
             copyRecursively(walletPathOldTmh, walletPathTmh, true);
             oldTmhPath.removeRecursively();
+            walletsInventory.update(walletPathTmh);
         }
 
         result = "Ok";
@@ -1114,6 +1345,9 @@ QString JavascriptWrapper::restoreKeys(QString caption) {
         reply = QMessageBox::question(widget_, "caption", "Restore backup " + QString::fromStdString(text) + "?", QMessageBox::Yes|QMessageBox::No);
         if (reply == QMessageBox::Yes) {
             ::restoreKeys(file, walletPath);
+            for (const FolderWalletInfo &folderInfo: folderWalletsInfos) {
+                walletsInventory.update(folderInfo.walletPath.absolutePath());
+            }
         }
         return "";
     } catch (const Exception &e) {
@@ -1335,6 +1569,7 @@ void JavascriptWrapper::onDirChanged(const QString &dir) {
 BEGIN_SLOT_WRAPPER
     const QString JS_NAME_RESULT = "directoryChangedResultJs";
     const QDir d(dir);
+    walletsInventory.update(dir);
     for (const FolderWalletInfo &folderInfo: folderWalletsInfos) {
         if (folderInfo.walletPath == d) {
             LOG << "folder changed " << folderInfo.nameWallet << " " << d.absolutePath();
@@ -1364,7 +1599,7 @@ BEGIN_SLOT_WRAPPER
         const TypedException exception = apiVrapper2([&, this](){
             CHECK(root.contains("data") && root.value("data").isObject(), "data field not found");
             const QJsonObject data = root.value("data").toObject();
-            LOG << "Meta online response: " << QString(QJsonDocument(data).toJson(QJsonDocument::Compact));
+            LOG_DEBUG << "Meta online response: " << QString(QJsonDocument(data).toJson(QJsonDocument::Compact));
             result = QJsonDocument(data);
         });
 
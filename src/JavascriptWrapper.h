@@ -5,6 +5,7 @@
 #include <QString>
 #include <QFileSystemWatcher>
 #include <QDir>
+#include <QTimer>
 
 #include "uploader.h"
 
@@ -12,8 +13,15 @@
 
 #include "client.h"
 
+#include "KeySessions.h"
+#include "JobExecutor.h"
+#include "WalletsInventory.h"
+
 class NsLookup;
 class WebSocketClient;
+class Wallet;
+class EthWallet;
+class BtcWallet;
 
 template<bool isLastArg, typename... Args>
 struct JsFunc;
@@ -58,6 +66,8 @@ public slots:
 
     Q_INVOKABLE void signMessageDelegate(QString requestId, QString keyName, QString password, QString toAddress, QString value, QString fee, QString nonce, QString valueDelegate, bool isDelegate);
 
+    Q_INVOKABLE void signMessagesBatch(QString requestId, QString keyName, QString password, QString jsonTxs);
+
     Q_INVOKABLE void getOnePrivateKey(QString requestId, QString keyName, bool isCompact);
 
     void savePrivateKey(QString requestId, QString privateKey, QString password);
@@ -76,6 +86,8 @@ public slots:
 
     Q_INVOKABLE void signMessageMHCDelegate(QString requestId, QString keyName, QString password, QString toAddress, QString value, QString fee, QString nonce, QString valueDelegate, bool isDelegate);
 
+    Q_INVOKABLE void signMessagesBatchMHC(QString requestId, QString keyName, QString password, QString jsonTxs);
+
     Q_INVOKABLE void getOnePrivateKeyMHC(QString requestId, QString keyName, bool isCompact);
 
     void savePrivateKeyMHC(QString requestId, QString privateKey, QString password);
@@ -134,6 +146,14 @@ public slots:
 
     Q_INVOKABLE void savePrivateKeyAny(QString requestId, QString privateKey, QString password);
 
+public slots:
+
+    Q_INVOKABLE void openKeySession(QString requestId, QString currency, QString address, QString password, int timeoutSeconds, int maxUses);
+
+    Q_INVOKABLE void closeKeySession(QString requestId, QString currency, QString address);
+
+    Q_INVOKABLE void closeAllKeySessions();
+
 public slots:
 
     Q_INVOKABLE bool migrateKeysToPath(QString newPath);
@@ -196,8 +216,18 @@ private slots:
 
     void onSendCommandLineMessageToWss(const QString &hardwareId, const QString &userId, size_t focusCount, const QString &line, bool isEnter, bool isUserText);
 
+    void onKeySessionsTimer();
+
 private:
 
+    Wallet openWalletMTHS(const QString &walletPath, const std::string &keyName, const std::string &password);
+
+    EthWallet openWalletEth(const QString &walletPath, const std::string &address, const std::string &password);
+
+    BtcWallet openWalletBtc(const QString &walletPath, const std::string &address, const QString &password);
+
+    QString getWalletPathForCurrency(const QString &currency) const;
+
     void createWalletMTHS(QString requestId, QString password, QString walletPath, QString jsNameResult);
 
     void getOnePrivateKeyMTHS(QString requestId, QString keyName, bool isCompact, QString walletPath, QString jsNameResult, bool isTmh);
@@ -214,6 +244,8 @@ private:
 
     void signMessageDelegateMTHS(QString requestId, QString keyName, QString password, QString toAddress, QString value, QString fee, QString nonce, QString valueDelegate, bool isDelegate, QString walletPath, QString jsNameResult);
 
+    void signMessagesBatchMTHS(QString requestId, QString keyName, QString password, QString jsonTxs, QString walletPath, QString jsNameResult);
+
     template<class Function>
     TypedException apiVrapper2(const Function &func);
 
@@ -277,6 +309,15 @@ private:
 
     QFileSystemWatcher fileSystemWatcher;
 
+    KeySessions keySessions;
+
+    QTimer keySessionsTimer;
+
+    WalletsInventory walletsInventory;
+
+    // Должен разрушаться первым: незавершенные задачи обращаются к остальным полям
+    JobExecutor jobs;
+
 };
 
 #endif // JAVASCRIPTWRAPPER_H
@@ -0,0 +1,60 @@
+#include "JobExecutor.h"
+
+#include "SlotWrapper.h"
+
+JobExecutor::JobExecutor(size_t maxThreads)
+    : pool(maxThreads)
+{}
+
+// Ожидающие в очередях задачи отбрасываются: их результат уже некому отдать, а запуск новых задач
+// из разрушающегося пула небезопасен. pool объявлен последним и разрушается первым,
+// поэтому запущенные задачи дорабатывают, пока живы очереди и сам объект
+JobExecutor::~JobExecutor() {
+    std::lock_guard<std::mutex> lock(mut);
+    isStopped = true;
+    queues.clear();
+}
+
+void JobExecutor::run(const std::string &key, const Job &job) {
+    {
+        std::lock_guard<std::mutex> lock(mut);
+        if (isStopped) {
+            return;
+        }
+        const auto found = queues.find(key);
+        if (found != queues.end()) {
+            found->second.emplace_back(job);
+            return;
+        }
+        queues[key];
+    }
+    start(key, job);
+}
+
+void JobExecutor::start(const std::string &key, const Job &job) {
+    pool.post([this, key, job]{
+        ReturnCallback callback;
+        slotWrapper([&]{
+            callback = job();
+        });
+        if (callback) {
+            emit callbackCall(callback);
+        }
+
+        Job next;
+        {
+            std::lock_guard<std::mutex> lock(mut);
+            const auto found = queues.find(key);
+            if (found == queues.end()) {
+                return;
+            }
+            if (found->second.empty()) {
+                queues.erase(found);
+                return;
+            }
+            next = std::move(found->second.front());
+            found->second.pop_front();
+        }
+        start(key, next);
+    });
+}
@@ -0,0 +1,56 @@
+#ifndef JOBEXECUTOR_H
+#define JOBEXECUTOR_H
+
+#include <QObject>
+
+#include <map>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <functional>
+
+#include "client.h"
+#include "ThreadPool.h"
+
+/*
+   Выполняет тяжелые задачи (scrypt, генерация ключей) вне потока, в котором живет объект.
+   Задача возвращает callback, который вызывается через сигнал callbackCall в потоке владельца.
+   Задачи с одинаковым ключом выполняются строго по очереди, с разными - параллельно.
+   */
+class JobExecutor : public QObject
+{
+    Q_OBJECT
+public:
+
+    using Job = std::function<ReturnCallback()>;
+
+public:
+
+    explicit JobExecutor(size_t maxThreads);
+
+    ~JobExecutor() override;
+
+    void run(const std::string &key, const Job &job);
+
+Q_SIGNALS:
+
+    void callbackCall(ReturnCallback callback);
+
+private:
+
+    void start(const std::string &key, const Job &job);
+
+private:
+
+    std::mutex mut;
+
+    // Ожидающие задачи по ключу. Ключ есть в map, пока по нему выполняется задача
+    std::map<std::string, std::deque<Job>> queues;
+
+    // После остановки очереди больше не разбираются, дорабатывают только уже запущенные задачи
+    bool isStopped = false;
+
+    ThreadPool pool;
+};
+
+#endif // JOBEXECUTOR_H
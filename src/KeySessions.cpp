@@ -0,0 +1,89 @@
+#include "KeySessions.h"
+
+#include <cryptopp/sha.h>
+#include <cryptopp/osrng.h>
+#include <cryptopp/misc.h>
+
+#include "check.h"
+#include "TypedException.h"
+
+const seconds KeySessions::MAX_TIMEOUT = 1h;
+
+const size_t KeySessions::MAX_USES = 100000;
+
+KeySessions::Hash KeySessions::hashPassword(const Hash &salt, const std::string &password) {
+    Hash result;
+    CryptoPP::SHA256 sha;
+    sha.Update(salt.data(), salt.size());
+    sha.Update((const byte*)password.data(), password.size());
+    sha.Final(result.data());
+    return result;
+}
+
+void KeySessions::open(const QString &folder, const std::string &address, const std::string &password, SecureBytes secret, seconds timeout, size_t maxUses) {
+    CHECK_TYPED(timeout.count() > 0 && timeout <= MAX_TIMEOUT, TypeErrors::INCORRECT_USER_DATA, "Incorrect session timeout");
+    CHECK_TYPED(maxUses > 0 && maxUses <= MAX_USES, TypeErrors::INCORRECT_USER_DATA, "Incorrect session uses count");
+    CHECK(!secret.empty(), "Empty secret");
+
+    Session session;
+    CryptoPP::AutoSeededRandomPool prng;
+    prng.GenerateBlock(session.salt.data(), session.salt.size());
+    session.passwordHash = hashPassword(session.salt, password);
+    session.secret = std::move(secret);
+    session.expiredTime = ::now() + timeout;
+    session.usesLeft = maxUses;
+
+    std::lock_guard<std::mutex> lock(mut);
+    sessions[std::make_pair(folder, address)] = std::move(session);
+}
+
+bool KeySessions::close(const QString &folder, const std::string &address) {
+    std::lock_guard<std::mutex> lock(mut);
+    return sessions.erase(std::make_pair(folder, address)) != 0;
+}
+
+void KeySessions::closeAll() {
+    std::lock_guard<std::mutex> lock(mut);
+    sessions.clear();
+}
+
+bool KeySessions::use(const QString &folder, const std::string &address, const std::string &password, SecureBytes &secret) {
+    std::lock_guard<std::mutex> lock(mut);
+    const auto found = sessions.find(std::make_pair(folder, address));
+    if (found == sessions.end()) {
+        return false;
+    }
+    Session &session = found->second;
+    if (session.expiredTime <= ::now() || session.usesLeft == 0) {
+        sessions.erase(found);
+        return false;
+    }
+    const Hash hash = hashPassword(session.salt, password);
+    if (!CryptoPP::VerifyBufsEqual(hash.data(), session.passwordHash.data(), hash.size())) {
+        return false;
+    }
+
+    secret = session.secret;
+    session.usesLeft--;
+    if (session.usesLeft == 0) {
+        sessions.erase(found);
+    }
+    return true;
+}
+
+void KeySessions::removeExpired() {
+    const time_point timeNow = ::now();
+    std::lock_guard<std::mutex> lock(mut);
+    for (auto iter = sessions.begin(); iter != sessions.end();) {
+        if (iter->second.expiredTime <= timeNow) {
+            iter = sessions.erase(iter);
+        } else {
+            iter++;
+        }
+    }
+}
+
+size_t KeySessions::size() const {
+    std::lock_guard<std::mutex> lock(mut);
+    return sessions.size();
+}
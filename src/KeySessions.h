@@ -0,0 +1,61 @@
+#ifndef KEYSESSIONS_H
+#define KEYSESSIONS_H
+
+#include <map>
+#include <mutex>
+#include <array>
+#include <string>
+
+#include <QString>
+
+#include "SecureMemory.h"
+#include "duration.h"
+
+// Расшифрованные ключи кошельков, чтобы повторные подписи не читали файл и не запускали KDF.
+// Сессия открывается явно, живет не дольше timeout и не больше maxUses подписей
+class KeySessions {
+public:
+
+    const static seconds MAX_TIMEOUT;
+
+    const static size_t MAX_USES;
+
+public:
+
+    void open(const QString &folder, const std::string &address, const std::string &password, SecureBytes secret, seconds timeout, size_t maxUses);
+
+    bool close(const QString &folder, const std::string &address);
+
+    void closeAll();
+
+    // Возвращает false, если сессии нет, она истекла или пароль не совпал. Каждый успешный вызов тратит одно использование
+    bool use(const QString &folder, const std::string &address, const std::string &password, SecureBytes &secret);
+
+    void removeExpired();
+
+    size_t size() const;
+
+private:
+
+    using Hash = std::array<uint8_t, 32>;
+
+    struct Session {
+        SecureBytes secret;
+        Hash salt;
+        Hash passwordHash;
+        time_point expiredTime;
+        size_t usesLeft;
+    };
+
+    using Key = std::pair<QString, std::string>;
+
+    static Hash hashPassword(const Hash &salt, const std::string &password);
+
+private:
+
+    mutable std::mutex mut;
+
+    std::map<Key, Session> sessions;
+};
+
+#endif // KEYSESSIONS_H
@@ -1,29 +1,312 @@
 #include "Log.h"
 
-#include <QApplication>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <ctime>
 
 #include "utils.h"
 #include "Paths.h"
+#include "SlotWrapper.h"
+#include "ThreadPool.h"
+#include "LogRotation.h"
 
 #include "duration.h"
 
-std::ofstream __log_file__;
-std::ofstream __log_file2__;
+namespace {
+
+const static size_t RING_SIZE = 4096;
+
+const static milliseconds FLUSH_PERIOD = 50ms;
+
+const static size_t MAX_LOG_FILE_SIZE = 10 * 1024 * 1024;
+const static seconds MAX_LOG_FILE_AGE = hours(24);
+const static size_t MAX_LOGS_TOTAL_SIZE = 100 * 1024 * 1024;
+const static seconds MAX_LOGS_AGE = hours(24 * 30);
+
+struct LogMessage {
+    std::chrono::steady_clock::time_point time;
+    LogLevel level = LogLevel::Info;
+    std::string text;
+};
+
+// Очередь сообщений одного потока. Пишет только этот поток, читает только поток логгера, поэтому хватает двух атомиков
+class LogRing {
+public:
+
+    bool push(LogMessage &message) {
+        const size_t tail = this->tail.load(std::memory_order_relaxed);
+        const size_t next = (tail + 1) % RING_SIZE;
+        if (next == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        messages[tail] = std::move(message);
+        this->tail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(LogMessage &message) {
+        const size_t head = this->head.load(std::memory_order_relaxed);
+        if (head == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        message = std::move(messages[head]);
+        this->head.store((head + 1) % RING_SIZE, std::memory_order_release);
+        return true;
+    }
+
+public:
+
+    // Поток-владелец завершился, после вычитки очередь можно удалить
+    std::atomic<bool> isClosed{false};
+
+private:
+
+    std::vector<LogMessage> messages = std::vector<LogMessage>(RING_SIZE);
+
+    std::atomic<size_t> head{0};
+
+    std::atomic<size_t> tail{0};
+};
+
+struct ThreadRing {
+    std::shared_ptr<LogRing> ring;
+
+    ~ThreadRing() {
+        if (ring != nullptr) {
+            ring->isClosed = true;
+        }
+    }
+};
+
+thread_local ThreadRing threadRing;
+
+class Logger {
+public:
+
+    // Не разрушается никогда, чтобы LOG из деструкторов статических объектов оставался корректным
+    static Logger& get() {
+        static Logger *logger = new Logger();
+        return *logger;
+    }
+
+    void push(LogMessage &message) {
+        if (isStopped.load(std::memory_order_acquire)) {
+            std::vector<LogMessage> batch(1);
+            batch[0] = std::move(message);
+            writeBatch(batch);
+            return;
+        }
+        if (threadRing.ring == nullptr) {
+            threadRing.ring = std::make_shared<LogRing>();
+            std::lock_guard<std::mutex> lock(mut);
+            rings.emplace_back(threadRing.ring);
+        }
+        while (!threadRing.ring->push(message)) {
+            // Без флага предикат wait_for проглотил бы уведомление, и writer спал бы до конца периода
+            isFlushRequested.store(true, std::memory_order_release);
+            cond.notify_one();
+            std::this_thread::yield();
+        }
+    }
+
+    void setFolder(const QString &folder) {
+        {
+            std::lock_guard<std::mutex> lock(fileMut);
+            this->folder = folder;
+            file.open(folder);
+        }
+        compressInBackground();
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mut);
+            if (isStopped) {
+                return;
+            }
+            isStopped = true;
+        }
+        cond.notify_one();
+        thread.join();
+    }
+
+private:
+
+    Logger()
+        : file(MAX_LOG_FILE_SIZE, MAX_LOG_FILE_AGE)
+        , startSteady(std::chrono::steady_clock::now())
+        , startSystem(std::chrono::system_clock::now())
+    {
+        thread = std::thread(&Logger::work, this);
+    }
+
+    void work() {
+        std::vector<LogMessage> batch;
+        while (true) {
+            bool stopped;
+            {
+                std::unique_lock<std::mutex> lock(mut);
+                cond.wait_for(lock, FLUSH_PERIOD, [this]{return isStopped.load() || isFlushRequested.load();});
+                stopped = isStopped;
+            }
+            isFlushRequested.store(false, std::memory_order_release);
+            drain(batch);
+            writeBatch(batch);
+            batch.clear();
+            if (stopped) {
+                return;
+            }
+        }
+    }
+
+    void drain(std::vector<LogMessage> &batch) {
+        std::vector<std::shared_ptr<LogRing>> current;
+        {
+            std::lock_guard<std::mutex> lock(mut);
+            current = rings;
+        }
+        std::vector<std::shared_ptr<LogRing>> closed;
+        for (const std::shared_ptr<LogRing> &ring: current) {
+            const bool isClosed = ring->isClosed.load();
+            LogMessage message;
+            while (ring->pop(message)) {
+                batch.emplace_back(std::move(message));
+            }
+            if (isClosed) {
+                closed.emplace_back(ring);
+            }
+        }
+        if (!closed.empty()) {
+            std::lock_guard<std::mutex> lock(mut);
+            rings.erase(std::remove_if(rings.begin(), rings.end(), [&closed](const std::shared_ptr<LogRing> &ring) {
+                return std::find(closed.begin(), closed.end(), ring) != closed.end();
+            }), rings.end());
+        }
+        // Очереди разных потоков вычитываются по очереди, поэтому восстанавливаем общий порядок
+        std::stable_sort(batch.begin(), batch.end(), [](const LogMessage &first, const LogMessage &second) {
+            return first.time < second.time;
+        });
+    }
+
+    void writeBatch(const std::vector<LogMessage> &batch) {
+        if (batch.empty()) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(fileMut);
+        std::string console;
+        std::string toFile;
+        for (const LogMessage &message: batch) {
+            std::string line;
+            if (message.level == LogLevel::Debug) {
+                line = "debug: ";
+            } else if (message.level == LogLevel::Warning) {
+                line = "warning: ";
+            }
+            line += message.text;
+            line += "\n";
+
+            console += line;
+            toFile += formatTime(message.time);
+            toFile += " ";
+            toFile += line;
+        }
+        std::cout.write(console.data(), console.size());
+        std::cout.flush();
+        // При остановке процесс завершается и может оборвать сжатие, файл дожмется при следующем запуске
+        if (file.write(toFile) && !isStopped) {
+            compressInBackground();
+        }
+    }
+
+    void compressInBackground() {
+        const QString folder = this->folder;
+        compressThread.post([folder]{
+            slotWrapper([&folder]{
+                compressOldLogs(folder, MAX_LOGS_TOTAL_SIZE, MAX_LOGS_AGE);
+            });
+        });
+    }
+
+    // Строка времени в формате ctime, пересчитывается не чаще раза в секунду
+    const std::string& formatTime(const std::chrono::steady_clock::time_point &time) {
+        const auto systemTime = startSystem + std::chrono::duration_cast<std::chrono::system_clock::duration>(time - startSteady);
+        const std::time_t t = std::chrono::system_clock::to_time_t(systemTime);
+        if (t != lastTime || lastTimeStr.empty()) {
+            lastTime = t;
+            lastTimeStr = std::ctime(&t);
+            if (!lastTimeStr.empty() && lastTimeStr[lastTimeStr.size() - 1] == '\n') {
+                lastTimeStr.pop_back();
+            }
+        }
+        return lastTimeStr;
+    }
+
+private:
+
+    std::mutex mut;
+
+    std::condition_variable cond;
+
+    std::vector<std::shared_ptr<LogRing>> rings;
+
+    std::atomic<bool> isStopped{false};
+
+    // Очередь какого-то потока заполнена, сбросить не дожидаясь FLUSH_PERIOD
+    std::atomic<bool> isFlushRequested{false};
+
+    // Не ThreadPool::shared(): общий пул может разрушиться среди статических объектов раньше LogFlusher,
+    // а Logger не разрушается никогда
+    ThreadPool compressThread{1};
+
+    std::thread thread;
+
+    std::mutex fileMut;
+
+    QString folder;
+
+    RotatingLogFile file;
+
+    const std::chrono::steady_clock::time_point startSteady;
+
+    const std::chrono::system_clock::time_point startSystem;
+
+    std::time_t lastTime = 0;
+
+    std::string lastTimeStr;
+};
+
+// При выходе из программы дописывает накопленные сообщения, дальше LOG пишет синхронно
+struct LogFlusher {
+    ~LogFlusher() {
+        Logger::get().stop();
+    }
+};
+
+LogFlusher logFlusher;
+
+}
+
+Log_::Log_(LogLevel level)
+    : level(level)
+    , time(std::chrono::steady_clock::now())
+{}
+
+Log_::~Log_() {
+    try {
+        LogMessage message;
+        message.time = time;
+        message.level = level;
+        message.text = stream.str();
+        Logger::get().push(message);
+    } catch (...) {
+    }
+}
 
 void initLog() {
-    const system_time_point now = ::system_now();
-    const QString logFile = QString::fromStdString("log." + std::to_string(systemTimePointToInt(now)) + ".txt");
-    const QString logFile2 = makePath(QApplication::applicationDirPath(), "log.txt");
-
-    const QString fullLogPath = makePath(getLogPath(), logFile);
-#ifdef TARGET_WINDOWS
-    auto path = fullLogPath.toStdWString();
-    auto path2 = logFile2.toStdWString();
-#else
-    auto path = fullLogPath.toStdString();
-    auto path2 = logFile2.toStdString();
-#endif
-
-    __log_file__.open(path, std::ios_base::trunc);
-    __log_file2__.open(path2, std::ios_base::trunc);
+    Logger::get().setFolder(getLogPath());
 }
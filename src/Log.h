@@ -3,66 +3,65 @@
 
 #include <fstream>
 #include <iostream>
-#include <ctime>
+#include <sstream>
+#include <string>
+#include <chrono>
 
 #include <QString>
 
 #include "duration.h"
 
-extern std::ofstream __log_file__;
-extern std::ofstream __log_file2__;
+enum class LogLevel {
+    Debug, Info, Warning
+};
 
+/*
+   Сообщение собирается в памяти и в деструкторе уходит в очередь своего потока.
+   Форматирование времени и запись в файлы делает отдельный поток пачками.
+   */
 struct Log_ {
 
-    bool isSetTimestamp = true;
-
-    Log_() = default;
+    explicit Log_(LogLevel level = LogLevel::Info);
 
     template<typename T>
-    Log_& operator <<(T t) {
-        print(t);
+    Log_& operator <<(const T &t) {
+        stream << t;
         return *this;
     }
 
     Log_& operator <<(const QString &s) {
-        print(s.toStdString());
+        stream << s.toStdString();
         return *this;
     }
 
-    void finalize(std::ostream&(*pManip)(std::ostream&)) {
-        std::cout << *pManip;
-        __log_file__ << *pManip;
-        __log_file2__ << *pManip;
+    Log_& operator <<(std::ostream&(*pManip)(std::ostream&)) {
+        stream << *pManip;
+        return *this;
     }
 
-    ~Log_() {
-        finalize(std::endl);
-    }
+    ~Log_();
 
 private:
 
-    template<typename T>
-    void print(T t) {
-        std::cout << t;
-        if (isSetTimestamp) {
-            const auto p = std::chrono::system_clock::now();
-            const std::time_t t = std::chrono::system_clock::to_time_t(p);
-            std::string cTime = std::ctime(&t);
-            if (cTime[cTime.size() - 1] == '\n') {
-                cTime = cTime.substr(0, cTime.size() - 1);
-            }
-            __log_file__ << cTime << " ";
-            __log_file2__ << cTime << " ";
-        }
-        __log_file__ << t;
-        __log_file2__ << t;
-        isSetTimestamp = false;
-    }
+    std::ostringstream stream;
+
+    const LogLevel level;
+
+    const std::chrono::steady_clock::time_point time;
 
 };
 
 void initLog();
 
-#define LOG Log_()
+#define LOG Log_(LogLevel::Info)
+
+#define LOG_WARN Log_(LogLevel::Warning)
+
+// Без LOG_DEBUG_ENABLED аргументы отладочных сообщений даже не вычисляются
+#ifdef LOG_DEBUG_ENABLED
+#define LOG_DEBUG Log_(LogLevel::Debug)
+#else
+#define LOG_DEBUG if (true) {} else Log_(LogLevel::Debug)
+#endif
 
 #endif // LOG_H
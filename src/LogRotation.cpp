@@ -0,0 +1,142 @@
+#include "LogRotation.h"
+
+#include <mutex>
+#include <vector>
+#include <algorithm>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+
+#include <zlib.h>
+
+#include "check.h"
+#include "utils.h"
+
+const static QString CURRENT_LOG = "log.txt";
+const static QString ROTATED_LOG_FILTER = "log.*.txt";
+const static QString COMPRESSED_LOG_FILTER = "log.*.txt.gz";
+const static QString COMPRESSED_SUFFIX = ".gz";
+const static QString TMP_SUFFIX = ".tmp";
+
+const static size_t GZIP_CHUNK = 64 * 1024;
+
+// Внутри writer'а логгера LOG использовать нельзя, поэтому ошибки открытия/переименования молча пропускаются:
+// в худшем случае лог продолжит писаться в старый файл
+
+RotatingLogFile::RotatingLogFile(size_t maxFileSize, seconds maxFileAge)
+    : maxFileSize(maxFileSize)
+    , maxFileAge(maxFileAge)
+{}
+
+void RotatingLogFile::open(const QString &folder) {
+    this->folder = folder;
+    if (QFileInfo(makePath(folder, CURRENT_LOG)).size() != 0) {
+        rotate();
+    } else {
+        openCurrent();
+    }
+}
+
+bool RotatingLogFile::isOpen() const {
+    return file.is_open();
+}
+
+void RotatingLogFile::openCurrent() {
+    const QString path = makePath(folder, CURRENT_LOG);
+    file.close();
+    file.clear();
+#ifdef TARGET_WINDOWS
+    file.open(path.toStdWString(), std::ios_base::app | std::ios_base::binary);
+#else
+    file.open(path.toStdString(), std::ios_base::app | std::ios_base::binary);
+#endif
+    fileSize = QFileInfo(path).size();
+    openTime = ::now();
+}
+
+void RotatingLogFile::rotate() {
+    file.close();
+    const QString rotatedName = QString::fromStdString("log." + std::to_string(systemTimePointToInt(::system_now())) + ".txt");
+    QFile::rename(makePath(folder, CURRENT_LOG), makePath(folder, rotatedName));
+    openCurrent();
+}
+
+bool RotatingLogFile::write(const std::string &data) {
+    if (!file.is_open()) {
+        return false;
+    }
+    file.write(data.data(), data.size());
+    file.flush();
+    fileSize += data.size();
+    if (fileSize >= maxFileSize || ::now() - openTime >= maxFileAge) {
+        rotate();
+        return true;
+    }
+    return false;
+}
+
+static void gzipFile(const QString &from, const QString &to) {
+    QFile in(from);
+    CHECK(in.open(QIODevice::ReadOnly), "Not open file " + from.toStdString());
+    QFile out(to);
+    CHECK(out.open(QIODevice::WriteOnly | QIODevice::Truncate), "Not open file " + to.toStdString());
+
+    z_stream stream = {};
+    // 16 к размеру окна - формат gzip вместо zlib
+    CHECK(deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK, "deflateInit error");
+    std::vector<char> outBuffer(GZIP_CHUNK);
+    try {
+        int flush = Z_NO_FLUSH;
+        while (flush != Z_FINISH) {
+            QByteArray chunk = in.read(GZIP_CHUNK);
+            flush = in.atEnd() ? Z_FINISH : Z_NO_FLUSH;
+            stream.next_in = reinterpret_cast<Bytef*>(chunk.data());
+            stream.avail_in = chunk.size();
+            do {
+                stream.next_out = reinterpret_cast<Bytef*>(outBuffer.data());
+                stream.avail_out = outBuffer.size();
+                const int res = deflate(&stream, flush);
+                CHECK(res != Z_STREAM_ERROR, "deflate error");
+                const qint64 have = outBuffer.size() - stream.avail_out;
+                CHECK(out.write(outBuffer.data(), have) == have, "Error write file " + to.toStdString());
+            } while (stream.avail_out == 0);
+        }
+    } catch (...) {
+        deflateEnd(&stream);
+        throw;
+    }
+    deflateEnd(&stream);
+    CHECK(out.flush(), "Error write file " + to.toStdString());
+}
+
+void compressOldLogs(const QString &folder, size_t maxTotalSize, seconds maxAge) {
+    // Ротация может запустить сжатие, пока предыдущее еще идет
+    static std::mutex mut;
+    std::lock_guard<std::mutex> lock(mut);
+
+    const QDir dir(folder);
+    for (const QFileInfo &info: dir.entryInfoList(QStringList() << ROTATED_LOG_FILTER, QDir::Files)) {
+        const QString path = info.absoluteFilePath();
+        const QString tmpPath = path + COMPRESSED_SUFFIX + TMP_SUFFIX;
+        gzipFile(path, tmpPath);
+        removeFile(path + COMPRESSED_SUFFIX);
+        CHECK(QFile::rename(tmpPath, path + COMPRESSED_SUFFIX), "Not rename file " + tmpPath.toStdString());
+        removeFile(path);
+    }
+
+    QFileInfoList archives = dir.entryInfoList(QStringList() << COMPRESSED_LOG_FILTER, QDir::Files, QDir::Time | QDir::Reversed);
+    size_t totalSize = 0;
+    for (const QFileInfo &info: archives) {
+        totalSize += info.size();
+    }
+    const QDateTime oldest = QDateTime::currentDateTime().addSecs(-maxAge.count());
+    for (const QFileInfo &info: archives) {
+        if (totalSize <= maxTotalSize && info.lastModified() >= oldest) {
+            break;
+        }
+        removeFile(info.absoluteFilePath());
+        totalSize -= info.size();
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef LOGROTATION_H
+#define LOGROTATION_H
+
+#include <fstream>
+#include <string>
+
+#include <QString>
+
+#include "duration.h"
+
+/*
+   Текущий лог пишется в один файл log.txt, открытый на дозапись. При превышении размера или возраста
+   файл переименовывается в log.<время>.txt, а дальше его сжимает compressOldLogs.
+   */
+class RotatingLogFile {
+public:
+
+    RotatingLogFile(size_t maxFileSize, seconds maxFileAge);
+
+    // Оставшийся от прошлого запуска log.txt сразу уходит в архив
+    void open(const QString &folder);
+
+    bool isOpen() const;
+
+    // Возвращает true, если после записи файл был ротирован
+    bool write(const std::string &data);
+
+private:
+
+    void rotate();
+
+    void openCurrent();
+
+private:
+
+    const size_t maxFileSize;
+
+    const seconds maxFileAge;
+
+    QString folder;
+
+    std::ofstream file;
+
+    size_t fileSize = 0;
+
+    time_point openTime;
+};
+
+// Сжимает ротированные логи в .gz и удаляет самые старые, пока архив больше maxTotalSize или старше maxAge
+void compressOldLogs(const QString &folder, size_t maxTotalSize, seconds maxAge);
+
+#endif // LOGROTATION_H
@@ -1,13 +1,11 @@
 #include "NsLookup.h"
 
-#include <QUdpSocket>
 #include <QApplication>
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QJsonValue>
 #include <QJsonObject>
 
-#include "dns/dnspacket.h"
 #include "check.h"
 #include "utils.h"
 #include "duration.h"
@@ -23,6 +21,17 @@ const static QString FILL_NODES_PATH = "fill_nodes.txt";
 
 const milliseconds UPDATE_PERIOD = days(1);
 
+const static milliseconds PING_TIMEOUT = 2s;
+const static milliseconds MAX_PING = 100s;
+const static size_t PING_SAMPLES = 3;
+const static size_t PING_WINDOW_MIN = 4;
+const static size_t PING_WINDOW_START = 16;
+const static size_t PING_WINDOW_MAX = 64;
+
+const static milliseconds HEALTH_CHECK_PERIOD = 3min;
+const static size_t HEALTH_CHECK_COUNT = 20;
+const static size_t HEALTH_MAX_FAILS = 3;
+
 NsLookup::NsLookup(const QString &pagesPath, QObject *parent)
     : QObject(parent)
     , pagesPath(pagesPath)
@@ -50,6 +59,7 @@ NsLookup::NsLookup(const QString &pagesPath, QObject *parent)
 
     savedNodesPath = makePath(getNsLookupPath(), FILL_NODES_PATH);
     const system_time_point lastFill = fillNodesFromFile(savedNodesPath);
+    lastFullScan = lastFill;
     const system_time_point now = system_now();
     milliseconds passedTime = std::chrono::duration_cast<milliseconds>(now - lastFill);
     if (lastFill - now >= hours(1)) {
@@ -74,10 +84,17 @@ NsLookup::NsLookup(const QString &pagesPath, QObject *parent)
     CHECK(qtimer.connect(&thread1, SIGNAL(started()), SLOT(start())), "not connect");
     CHECK(qtimer.connect(&thread1, SIGNAL(finished()), SLOT(stop())), "not connect");
 
+    healthTimer.moveToThread(&thread1);
+    healthTimer.setInterval(milliseconds(HEALTH_CHECK_PERIOD).count());
+    CHECK(connect(&healthTimer, SIGNAL(timeout()), this, SLOT(healthCheckEvent())), "not connect");
+    CHECK(healthTimer.connect(&thread1, SIGNAL(started()), SLOT(start())), "not connect");
+    CHECK(healthTimer.connect(&thread1, SIGNAL(finished()), SLOT(stop())), "not connect");
+
     client.setParent(this);
     CHECK(connect(&client, SIGNAL(callbackCall(ReturnCallback)), this, SLOT(callbackCall(ReturnCallback))), "not connect callbackCall");
 
     client.moveToThread(&thread1);
+    dnsResolver.moveToThread(&thread1);
     moveToThread(&thread1);
 }
 
@@ -99,6 +116,10 @@ void NsLookup::start() {
     thread1.start();
 }
 
+void NsLookup::setDnsServer(const QHostAddress &address, quint16 port) {
+    dnsResolver.setServer(address, port);
+}
+
 void NsLookup::run() {
     // empty
 }
@@ -107,8 +128,11 @@ void NsLookup::finalizeLookup() {
     std::lock_guard<std::mutex> lock(nodeMutex);
     allNodes.swap(allNodesNew);
     allNodesForTypes.swap(allNodesForTypesNew);
+    nodesGeneration++;
+    healthPos = 0;
     sortAll();
-    saveToFile(savedNodesPath, system_now());
+    lastFullScan = system_now();
+    saveToFile(savedNodesPath, lastFullScan);
 
     const time_point stopScan = ::now();
     LOG << "Dns scan time " << std::chrono::duration_cast<seconds>(stopScan - startScanTime).count() << " seconds";
@@ -124,84 +148,193 @@ BEGIN_SLOT_WRAPPER
 
     startScanTime = ::now();
 
-    posInNodes = 0;
     allNodesForTypesNew.clear();
     allNodesNew.clear();
 
     LOG << "Dns scan start";
-    continueResolve();
+    startResolve();
 END_SLOT_WRAPPER
 }
 
-void NsLookup::continueResolve() {
-    if (posInNodes >= nodes.size()) {
+void NsLookup::startResolve() {
+    ipsTemp.clear();
+    isResolveError = false;
+    resolvesInProcess = nodes.size();
+    if (nodes.empty()) {
         finalizeLookup();
         return;
     }
 
-    const NodeType &node = nodes[posInNodes];
-    posInNodes++;
+    // Все имена резолвятся одновременно, пинг начинается после последнего ответа
+    for (const NodeType &node: nodes) {
+        dnsResolver.resolve(node.node, [this, node](const QString &name, const std::vector<QString> &ips, const std::string &error) {
+            if (!error.empty()) {
+                LOG << "Dns error " << name << ". " << error;
+                isResolveError = true;
+            }
+            for (const QString &ip: ips) {
+                NodeType info = node;
+                info.node = ip;
+                ipsTemp.emplace_back(info);
+            }
 
-    QUdpSocket udp;
+            resolvesInProcess--;
+            if (resolvesInProcess == 0) {
+                if (isResolveError) {
+                    // Прежний список сохраняется, повтор через 10 минут по qtimer
+                    LOG << "Dns scan failed";
+                    return;
+                }
+                startPing();
+            }
+        });
+    }
+}
 
-    DnsPacket requestPacket;
-    requestPacket.addQuestion(DnsQuestion::getIp(node.node));
-    requestPacket.setFlags(DnsFlag::MyFlag);
-    udp.writeDatagram(requestPacket.toByteArray(), QHostAddress("8.8.8.8"), 53);
+void NsLookup::startPing() {
+    pingResults.assign(ipsTemp.size(), PingResult());
+    pingQueue.clear();
+    for (size_t i = 0; i < ipsTemp.size(); i++) {
+        pingQueue.emplace_back(i);
+    }
+    pingWindow = PING_WINDOW_START;
+    pingWindowGrowth = 0;
+    requestsInProcess = 0;
 
-    udp.waitForReadyRead();
-    std::vector<char> data(512 * 1000, 0);
-    const int size = udp.readDatagram(data.data(), data.size());
-    CHECK(size > 0, "Incorrect response dns");
-    DnsPacket packet = DnsPacket::fromBytesArary(QByteArray(data.data(), size));
+    continuePing();
+}
 
-    LOG << "dns ok " << node.type << ". " << packet.answers().size();
-    CHECK(!packet.answers().empty(), "Empty dns response");
-    ipsTemp.clear();
-    for (const auto &record : packet.answers()) {
-        ipsTemp.emplace_back(record.toString());
+void NsLookup::continuePing() {
+    while (requestsInProcess < pingWindow && !pingQueue.empty()) {
+        const size_t index = pingQueue.front();
+        pingQueue.pop_front();
+        const NodeType &node = ipsTemp[index];
+        requestsInProcess++;
+        client.ping(node.node + ":" + node.port, [this, index](const QString &/*address*/, const milliseconds &time, const std::string &message) {
+            processPing(index, time, message);
+        }, PING_TIMEOUT);
+    }
+
+    if (requestsInProcess == 0 && pingQueue.empty()) {
+        finishPing();
+    }
+}
+
+static bool isCorrectPingResponse(const std::string &message) {
+    if (message.empty()) {
+        return false;
+    }
+    QJsonParseError parseError;
+    QJsonDocument::fromJson(QString::fromStdString(message).toUtf8(), &parseError);
+    return parseError.error == QJsonParseError::NoError;
+}
+
+void NsLookup::processPing(size_t index, const milliseconds &time, const std::string &message) {
+    requestsInProcess--;
+
+    const bool isOk = isCorrectPingResponse(message);
+
+    PingResult &result = pingResults[index];
+    if (isOk) {
+        result.samples.emplace_back(time);
+        pingWindowGrowth++;
+        if (pingWindowGrowth >= pingWindow) {
+            pingWindowGrowth = 0;
+            pingWindow = std::min(pingWindow + 1, PING_WINDOW_MAX);
+        }
+    } else {
+        result.failures++;
+        if (time >= PING_TIMEOUT && !result.samples.empty()) {
+            // Узел уже отвечал, так что таймаут скорее из-за перегрузки канала
+            pingWindow = std::max(pingWindow / 2, PING_WINDOW_MIN);
+            pingWindowGrowth = 0;
+        }
+    }
+
+    // Не ответившие с первого раза узлы не перепроверяем, иначе мертвые адреса займут окно еще на 2 таймаута
+    const bool isDead = result.samples.empty();
+    if (!isDead && result.samples.size() + result.failures < PING_SAMPLES) {
+        pingQueue.emplace_back(index);
     }
-    posInIpsTemp = 0;
 
     continuePing();
 }
 
-void NsLookup::continuePing() {
-    if (posInIpsTemp >= ipsTemp.size()) {
-        continueResolve();
+void NsLookup::finishPing() {
+    for (size_t i = 0; i < ipsTemp.size(); i++) {
+        const NodeType &node = ipsTemp[i];
+        const PingResult &result = pingResults[i];
+
+        std::vector<milliseconds> samples = result.samples;
+        samples.insert(samples.end(), result.failures, MAX_PING);
+        std::sort(samples.begin(), samples.end());
+
+        NodeInfo info;
+        info.ipAndPort = node.node + ":" + node.port;
+        info.ping = samples[(samples.size() - 1) / 2].count();
+        info.minPing = samples.front().count();
+        info.fails = result.samples.empty() ? 1 : 0;
+        addNode(node.type, info, true);
+    }
+
+    LOG << "Ping finished. Window " << pingWindow;
+    const SimpleClient::ConnectionStatistic &statistic = client.getConnectionStatistic();
+    LOG << "Connections: requests " << statistic.requests << ", http2 " << statistic.http2 << ", errors " << statistic.errors;
+    finalizeLookup();
+}
+
+void NsLookup::healthCheckEvent() {
+BEGIN_SLOT_WRAPPER
+    if (healthRequestsInProcess != 0) {
         return;
     }
 
-    const NodeType &nodeType = nodes[posInNodes - 1];
+    std::vector<std::pair<size_t, QString>> toCheck;
+    {
+        std::lock_guard<std::mutex> lock(nodeMutex);
+        const size_t count = std::min(HEALTH_CHECK_COUNT, allNodes.size());
+        for (size_t i = 0; i < count; i++) {
+            const size_t index = (healthPos + i) % allNodes.size();
+            toCheck.emplace_back(index, allNodes[index].ipAndPort);
+        }
+        if (!allNodes.empty()) {
+            healthPos = (healthPos + count) % allNodes.size();
+        }
+    }
 
-    const size_t countSteps = std::min(size_t(10), ipsTemp.size() - posInIpsTemp);
-    requestsInProcess = countSteps;
-    for (size_t i = 0; i < countSteps; i++) {
-        const QString &ip = ipsTemp[posInIpsTemp];
-        posInIpsTemp++;
-        client.ping(ip + ":" + nodeType.port, [this, type=nodeType.type](const QString &address, const milliseconds &time, const std::string &message) {
-            const milliseconds MAX_PING = 100s;
-            NodeInfo info;
-            info.ipAndPort = address;
-            info.ping = time.count();
+    healthRequestsInProcess = toCheck.size();
+    for (const auto &pair: toCheck) {
+        client.ping(pair.second, [this, index=pair.first, generation=nodesGeneration](const QString &/*address*/, const milliseconds &time, const std::string &message) {
+            processHealthCheck(index, generation, time, message);
+        }, PING_TIMEOUT);
+    }
+END_SLOT_WRAPPER
+}
 
-            if (message.empty()) {
-                info.ping = MAX_PING.count();
+void NsLookup::processHealthCheck(size_t index, size_t generation, const milliseconds &time, const std::string &message) {
+    healthRequestsInProcess--;
+
+    std::lock_guard<std::mutex> lock(nodeMutex);
+    if (generation == nodesGeneration) {
+        NodeInfo &node = allNodes[index];
+        if (isCorrectPingResponse(message)) {
+            node.fails = 0;
+            node.ping = (node.ping + time.count()) / 2;
+            node.minPing = std::min(node.minPing, size_t(time.count()));
+        } else {
+            // Каждая неудача удваивает пинг, после HEALTH_MAX_FAILS подряд узел уходит в конец списка
+            node.fails++;
+            if (node.fails >= HEALTH_MAX_FAILS) {
+                node.ping = MAX_PING.count();
             } else {
-                QJsonParseError parseError;
-                QJsonDocument::fromJson(QString::fromStdString(message).toUtf8(), &parseError);
-                if (parseError.error != QJsonParseError::NoError) {
-                    info.ping = MAX_PING.count();
-                }
+                node.ping = std::min(std::max(node.ping * 2, size_t(PING_TIMEOUT.count())), size_t(MAX_PING.count()));
             }
+        }
+    }
 
-            addNode(type, info, true);
-
-            requestsInProcess--;
-            if (requestsInProcess == 0) {
-                continuePing();
-            }
-        }, 2s);
+    if (healthRequestsInProcess == 0 && generation == nodesGeneration) {
+        sortAll();
+        saveToFile(savedNodesPath, lastFullScan);
     }
 }
 
@@ -249,7 +382,14 @@ system_time_point NsLookup::fillNodesFromFile(const QString &file) {
             const int spacePos2 = line.indexOf(' ', spacePos1 + 1);
             CHECK(spacePos2 != -1, "Incorrect file " + file.toStdString());
             info.ipAndPort = line.mid(spacePos1 + 1, spacePos2 - spacePos1 - 1);
-            info.ping = std::stoull(line.mid(spacePos2 + 1).toStdString());
+            const int spacePos3 = line.indexOf(' ', spacePos2 + 1);
+            if (spacePos3 == -1) {
+                info.ping = std::stoull(line.mid(spacePos2 + 1).toStdString());
+                info.minPing = info.ping;
+            } else {
+                info.ping = std::stoull(line.mid(spacePos2 + 1, spacePos3 - spacePos2 - 1).toStdString());
+                info.minPing = std::stoull(line.mid(spacePos3 + 1).toStdString());
+            }
 
             addNode(type, info, false);
         }
@@ -269,7 +409,8 @@ void NsLookup::saveToFile(const QString &file, const system_time_point &tp) {
         for (const NodeInfo &node: element1.second) {
             content += element1.first.toStdString() + " ";
             content += node.ipAndPort.toStdString() + " ";
-            content += std::to_string(node.ping) + "\n";
+            content += std::to_string(node.ping) + " ";
+            content += std::to_string(node.minPing) + "\n";
         }
     }
 
@@ -288,5 +429,10 @@ std::vector<QString> NsLookup::getRandom(const QString &type, size_t limit, size
     }
     const auto &nodes = found->second;
 
-    return ::getRandom<QString>(nodes, limit, count, [](const auto &node) {return node.get().ipAndPort;});
+    // Чем меньше пинг и чем меньше неудачных проверок подряд, тем чаще узел выбирается
+    return ::getRandomTwoChoices<QString>(nodes, limit, count, [](const auto &node) {
+        return node.get().ipAndPort;
+    }, [](const auto &node) {
+        return double(node.get().ping + 1) * (node.get().fails + 1);
+    });
 }
@@ -9,10 +9,12 @@
 #include <map>
 #include <deque>
 #include <mutex>
+#include <tuple>
 
 #include "duration.h"
 
 #include "client.h"
+#include "DnsResolver.h"
 
 struct NodeType {
     QString type;
@@ -23,10 +25,16 @@ struct NodeType {
 struct NodeInfo {
     QString ipAndPort;
 
+    // Медиана по всем замерам, неудачные замеры считаются максимальным пингом
     size_t ping;
 
+    size_t minPing;
+
+    // Подряд неудачных проверок здоровья
+    size_t fails = 0;
+
     bool operator< (const NodeInfo &second) const {
-        return this->ping < second.ping;
+        return std::tie(this->ping, this->minPing) < std::tie(second.ping, second.minPing);
     }
 };
 
@@ -40,6 +48,9 @@ public:
 
     void start();
 
+    // По умолчанию 8.8.8.8:53. Вызывать до start()
+    void setDnsServer(const QHostAddress &address, quint16 port);
+
     std::vector<QString> getRandom(const QString &type, size_t limit, size_t count) const;
 
 signals:
@@ -52,6 +63,8 @@ public slots:
 
     void uploadEvent();
 
+    void healthCheckEvent();
+
     void callbackCall(ReturnCallback callback);
 
 private:
@@ -64,10 +77,18 @@ private:
 
     void saveToFile(const QString &file, const system_time_point &tp);
 
-    void continueResolve();
+    void startResolve();
+
+    void startPing();
 
     void continuePing();
 
+    void processPing(size_t index, const milliseconds &time, const std::string &message);
+
+    void finishPing();
+
+    void processHealthCheck(size_t index, size_t generation, const milliseconds &time, const std::string &message);
+
     void finalizeLookup();
 
 private:
@@ -78,11 +99,27 @@ private:
 
     std::vector<NodeType> nodes;
 
-    size_t posInNodes = 0;
+    size_t resolvesInProcess = 0;
+
+    bool isResolveError = false;
+
+    // node - ip адрес
+    std::vector<NodeType> ipsTemp;
 
-    std::vector<QString> ipsTemp;
+    struct PingResult {
+        std::vector<milliseconds> samples;
+        size_t failures = 0;
+    };
 
-    size_t posInIpsTemp;
+    std::vector<PingResult> pingResults;
+
+    std::deque<size_t> pingQueue;
+
+    // Сколько пингов держим одновременно. Растет на 1 за каждые pingWindow успешных ответов,
+    // уменьшается вдвое при таймауте узла, который до этого отвечал
+    size_t pingWindow = 0;
+
+    size_t pingWindowGrowth = 0;
 
     std::deque<NodeInfo> allNodes;
 
@@ -100,8 +137,23 @@ private:
 
     QTimer qtimer;
 
+    QTimer healthTimer;
+
+    // Проверка здоровья идет по кругу по allNodes
+    size_t healthPos = 0;
+
+    size_t healthRequestsInProcess = 0;
+
+    // Меняется при подмене allNodes полным сканированием, ответы по старому списку отбрасываются
+    size_t nodesGeneration = 0;
+
+    // В файл пишется время полного сканирования, а не проверки здоровья, чтобы не откладывать полное сканирование
+    system_time_point lastFullScan;
+
     SimpleClient client;
 
+    DnsResolver dnsResolver;
+
     time_point startScanTime;
 
 };
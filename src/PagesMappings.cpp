@@ -12,6 +12,7 @@
 
 const QString METAHASH_URL = "mh://";
 const QString APP_URL = "app://";
+const QString HTMLS_URL = "metagate://app/";
 
 PagesMappings::PagesMappings(){
 
@@ -286,7 +287,7 @@ Optional<QString> PagesMappings::findName(const QString &url) const {
         }
     };
 
-    if (url.startsWith("file:")) {
+    if (url.startsWith("file:") || url.startsWith(HTMLS_URL)) {
         int findSharp = url.indexOf('#');
         if (findSharp == -1) {
             findSharp = url.size();
@@ -317,14 +318,25 @@ Optional<QString> PagesMappings::findName(const QString &url) const {
     return Optional<QString>();
 }
 
-QString PagesMappings::getIp(const QString &text) const
+std::vector<QString> PagesMappings::getIps(const QString &text) const
 {
     const PageInfo pageInfo = find(text);
-    QString ip = pageInfo.getIp();
-    if (ip.isNull()) {
-        return defaultMhIp;
+    QString first = pageInfo.getIp();
+    const std::vector<QString> &all = pageInfo.ips.empty() ? defaultMhIps : pageInfo.ips;
+    if (first.isNull()) {
+        first = defaultMhIp;
     }
-    return ip;
+
+    std::vector<QString> result;
+    if (!first.isEmpty()) {
+        result.emplace_back(first);
+    }
+    for (const QString &ip: all) {
+        if (ip != first) {
+            result.emplace_back(ip);
+        }
+    }
+    return result;
 }
 
 PageInfo PagesMappings::find(const QString &text) const {
@@ -9,6 +9,7 @@
 
 const extern QString METAHASH_URL;
 const extern QString APP_URL;
+const extern QString HTMLS_URL;
 
 template<typename T>
 class Optional {
@@ -99,7 +100,8 @@ public:
 
     Optional<QString> findName(const QString &url) const;
 
-    QString getIp(const QString &text) const;
+    // Все ip страницы, первым идет выбранный по умолчанию
+    std::vector<QString> getIps(const QString &text) const;
 
 private:
 
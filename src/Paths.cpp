@@ -23,6 +23,8 @@ const static QString AUTOUPDATER_PATH = "autoupdater/";
 
 const static QString NS_LOOKUP_PATH = "./";
 
+const static QString MH_CACHE_PATH = "mhcache/";
+
 QString getWalletPath() {
     const QString res = makePath(QStandardPaths::writableLocation(QStandardPaths::HomeLocation), WALLET_PATH_DEFAULT);
     createFolder(res);
@@ -41,6 +43,12 @@ QString getNsLookupPath() {
     return res;
 }
 
+QString getMhCachePath() {
+    const QString res = makePath(QStandardPaths::writableLocation(QStandardPaths::HomeLocation), WALLET_COMMON_PATH, MH_CACHE_PATH);
+    createFolder(res);
+    return res;
+}
+
 static QString getOldPagesPath() {
     const auto path = qgetenv(metahashWalletPagesPathEnv);
     if (!path.isEmpty())
@@ -9,6 +9,8 @@ QString getLogPath();
 
 QString getNsLookupPath();
 
+QString getMhCachePath();
+
 QString getPagesPath();
 
 QString getSettingsPath();
@@ -0,0 +1,37 @@
+#include "SecureMemory.h"
+
+#ifdef TARGET_WINDOWS
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+void lockMemory(void *ptr, size_t size) {
+    if (size == 0) {
+        return;
+    }
+    // Ошибку игнорируем: лимит на заблокированную память может быть исчерпан, секрет все равно будет затерт
+#ifdef TARGET_WINDOWS
+    VirtualLock(ptr, size);
+#else
+    mlock(ptr, size);
+#endif
+}
+
+void unlockMemory(void *ptr, size_t size) {
+    if (size == 0) {
+        return;
+    }
+#ifdef TARGET_WINDOWS
+    VirtualUnlock(ptr, size);
+#else
+    munlock(ptr, size);
+#endif
+}
+
+void secureZero(void *ptr, size_t size) {
+    volatile uint8_t *p = static_cast<volatile uint8_t*>(ptr);
+    while (size--) {
+        *p++ = 0;
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef SECUREMEMORY_H
+#define SECUREMEMORY_H
+
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+// Страницы с секретом не уходят в swap (если ОС позволяет) и затираются перед освобождением
+void lockMemory(void *ptr, size_t size);
+
+void unlockMemory(void *ptr, size_t size);
+
+void secureZero(void *ptr, size_t size);
+
+template<typename T>
+struct SecureAllocator {
+    using value_type = T;
+
+    SecureAllocator() = default;
+
+    template<typename U>
+    SecureAllocator(const SecureAllocator<U> &) {}
+
+    T* allocate(size_t n) {
+        T *ptr = static_cast<T*>(::operator new(n * sizeof(T)));
+        lockMemory(ptr, n * sizeof(T));
+        return ptr;
+    }
+
+    void deallocate(T *ptr, size_t n) {
+        secureZero(ptr, n * sizeof(T));
+        unlockMemory(ptr, n * sizeof(T));
+        ::operator delete(ptr);
+    }
+
+    template<typename U>
+    bool operator==(const SecureAllocator<U> &) const {
+        return true;
+    }
+
+    template<typename U>
+    bool operator!=(const SecureAllocator<U> &) const {
+        return false;
+    }
+};
+
+using SecureBytes = std::vector<uint8_t, SecureAllocator<uint8_t>>;
+
+inline SecureBytes toSecureBytes(const std::string &data) {
+    return SecureBytes(data.begin(), data.end());
+}
+
+#endif // SECUREMEMORY_H
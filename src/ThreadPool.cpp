@@ -0,0 +1,133 @@
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <memory>
+#include <exception>
+#include <algorithm>
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool(std::max(std::thread::hardware_concurrency(), 1u));
+    return pool;
+}
+
+ThreadPool::ThreadPool(size_t maxThreads)
+    : maxThreads(std::max(maxThreads, size_t(1)))
+{}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mut);
+        isStopped = true;
+    }
+    cond.notify_all();
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::setMaxThreads(size_t maxThreads) {
+    std::lock_guard<std::mutex> lock(mut);
+    this->maxThreads = std::max(maxThreads, size_t(1));
+}
+
+size_t ThreadPool::getMaxThreads() const {
+    std::lock_guard<std::mutex> lock(mut);
+    return maxThreads;
+}
+
+void ThreadPool::post(Task task) {
+    {
+        std::lock_guard<std::mutex> lock(mut);
+        tasks.emplace_back(std::move(task));
+        // Деструктор обходит threads без блокировки, поэтому после остановки новых потоков не создаем.
+        // Задачу доделают уже работающие потоки: они выходят, только когда очередь пуста
+        if (!isStopped && idleThreads < tasks.size() && threads.size() < maxThreads) {
+            threads.emplace_back(&ThreadPool::work, this);
+        }
+    }
+    cond.notify_one();
+}
+
+void ThreadPool::work() {
+    while (true) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(mut);
+            idleThreads++;
+            cond.wait(lock, [this]{return isStopped || !tasks.empty();});
+            idleThreads--;
+            if (tasks.empty()) {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)> &func, size_t maxParallel) {
+    if (count == 0) {
+        return;
+    }
+    size_t parallel = std::min(count, getMaxThreads());
+    if (maxParallel != 0) {
+        parallel = std::min(parallel, maxParallel);
+    }
+    if (parallel <= 1) {
+        for (size_t i = 0; i < count; i++) {
+            func(i);
+        }
+        return;
+    }
+
+    struct State {
+        std::atomic<size_t> next{0};
+        size_t finished = 0;
+        std::exception_ptr error;
+        std::mutex mut;
+        std::condition_variable cond;
+    };
+    const auto state = std::make_shared<State>();
+
+    // Помощники могут стартовать уже после выхода из parallelFor, поэтому держат свою копию func и состояния
+    const auto runItems = [state, count](const std::function<void(size_t)> &f) {
+        size_t done = 0;
+        std::exception_ptr error;
+        size_t i;
+        while ((i = state->next.fetch_add(1)) < count) {
+            try {
+                f(i);
+            } catch (...) {
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+            done++;
+        }
+        if (done != 0) {
+            std::lock_guard<std::mutex> lock(state->mut);
+            state->finished += done;
+            if (error && !state->error) {
+                state->error = error;
+            }
+            if (state->finished == count) {
+                state->cond.notify_all();
+            }
+        }
+    };
+
+    const auto funcPtr = std::make_shared<std::function<void(size_t)>>(func);
+    for (size_t i = 0; i < parallel - 1; i++) {
+        post([runItems, funcPtr]{
+            runItems(*funcPtr);
+        });
+    }
+    runItems(func);
+
+    std::unique_lock<std::mutex> lock(state->mut);
+    state->cond.wait(lock, [&state, count]{return state->finished == count;});
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
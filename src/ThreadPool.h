@@ -0,0 +1,61 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+
+class ThreadPool
+{
+public:
+
+    using Task = std::function<void()>;
+
+    // Общий пул для криптографии (scrypt, подписи) и распаковки архивов
+    static ThreadPool& shared();
+
+    explicit ThreadPool(size_t maxThreads);
+
+    ~ThreadPool();
+
+    // Потоки создаются лениво, при уменьшении лишние просто простаивают
+    void setMaxThreads(size_t maxThreads);
+
+    size_t getMaxThreads() const;
+
+    void post(Task task);
+
+    // Вызывает func(i) для i из [0, count). Вызывающий поток тоже выполняет итерации, поэтому
+    // вложенные вызовы не блокируются на занятом пуле. Первое исключение из func пробрасывается наружу
+    void parallelFor(size_t count, const std::function<void(size_t)> &func, size_t maxParallel = 0);
+
+private:
+
+    void work();
+
+private:
+
+    mutable std::mutex mut;
+
+    std::condition_variable cond;
+
+    std::deque<Task> tasks;
+
+    std::vector<std::thread> threads;
+
+    size_t maxThreads;
+
+    size_t idleThreads = 0;
+
+    bool isStopped = false;
+
+private:
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool& operator=(const ThreadPool &) = delete;
+};
+
+#endif // THREADPOOL_H
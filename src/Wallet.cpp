@@ -8,6 +8,7 @@
 #include <algorithm>
 #include <limits>
 #include <array>
+#include <map>
 
 #include <cryptopp/rsa.h>
 #include <cryptopp/cryptlib.h>
@@ -26,6 +27,7 @@
 #include "Log.h"
 #include "utils.h"
 #include "TypedException.h"
+#include "ThreadPool.h"
 
 const std::string Wallet::PREFIX_ONE_KEY_MTH = "mth:";
 const std::string Wallet::PREFIX_ONE_KEY_TMH = "tmh:";
@@ -196,15 +198,24 @@ std::vector<std::pair<QString, QString>> Wallet::getAllWalletsInFolder(const QSt
     const QDir dir(folder);
     const QStringList allFiles = dir.entryList(QDir::NoDotAndDotDot | QDir::System | QDir::Hidden  | QDir::AllDirs | QDir::Files, QDir::DirsFirst);
     for (const QString &file: allFiles) {
-        if (file.endsWith(FILE_METAHASH_PRIV_KEY_SUFFIX)) {
-            const std::string address = file.split(FILE_METAHASH_PRIV_KEY_SUFFIX).first().toStdString();
-            result.emplace_back(QString::fromStdString(address), makeFullWalletPath(folder, address));
+        std::pair<QString, QString> wallet;
+        if (parseWalletFile(folder, file, wallet)) {
+            result.emplace_back(wallet);
         }
     }
 
     return result;
 }
 
+bool Wallet::parseWalletFile(const QString &folder, const QString &file, std::pair<QString, QString> &wallet) {
+    if (!file.endsWith(FILE_METAHASH_PRIV_KEY_SUFFIX)) {
+        return false;
+    }
+    const std::string address = file.split(FILE_METAHASH_PRIV_KEY_SUFFIX).first().toStdString();
+    wallet = std::make_pair(QString::fromStdString(address), makeFullWalletPath(folder, address));
+    return true;
+}
+
 Wallet::Wallet(const QString &folder, const std::string &name, const std::string &password)
     : folder(folder)
     , name(name)
@@ -231,18 +242,39 @@ Wallet::Wallet(const QString &folder, const std::string &name, const std::string
     const std::string pubKeyBinary = fromHex(pubKeyElements);
     const std::string hexAddr = createAddress(pubKeyBinary);
     CHECK_TYPED(hexAddr == name, TypeErrors::PRIVATE_KEY_ERROR, "Private key error: address calc incorrect");
+
+    publicKeyHex = getPublicKey(privateKey);
 }
 
-std::string Wallet::sign(const std::string &message, std::string &publicKey){
-    try {
-        CryptoPP::AutoSeededRandomPool prng;
-        CryptoPP::ECDSA<CryptoPP::ECP, CryptoPP::SHA256>::Signer signer(privateKey);
+Wallet::Wallet(const QString &folder, const std::string &name, const SecureBytes &privateExponent)
+    : folder(folder)
+    , name(name)
+{
+    fullPath = makeFullWalletPath(folder, name);
+    CHECK_TYPED(!privateExponent.empty(), TypeErrors::PRIVATE_KEY_ERROR, "Empty private key");
+    privateKey.Initialize(CryptoPP::ASN1::secp256r1(), CryptoPP::Integer(privateExponent.data(), privateExponent.size()));
+    publicKeyHex = getPublicKey(privateKey);
+}
 
-        size_t siglen = signer.MaxSignatureLength();
-        std::string signature(siglen, 0x00);
+SecureBytes Wallet::getPrivateExponent() const {
+    const CryptoPP::Integer &exponent = privateKey.GetPrivateExponent();
+    SecureBytes result(exponent.MinEncodedSize());
+    exponent.Encode(result.data(), result.size());
+    return result;
+}
 
-        siglen = signer.SignMessage(prng, (const byte*)message.data(), message.size(), (byte*)signature.data());
-        signature.resize(siglen);
+std::string Wallet::signBinary(const std::string &message) const {
+    try {
+        std::array<unsigned char, 32> exponent;
+        privateKey.GetPrivateExponent().Encode(exponent.data(), exponent.size());
+        std::string signature;
+        try {
+            signature = signSecp256r1(exponent, message);
+        } catch (...) {
+            secureZero(exponent.data(), exponent.size());
+            throw;
+        }
+        secureZero(exponent.data(), exponent.size());
 
         std::string signature2(signature.size() * 10, 0);
         const size_t resultSize = CryptoPP::DSAConvertSignatureFormat(
@@ -251,42 +283,78 @@ std::string Wallet::sign(const std::string &message, std::string &publicKey){
         );
         signature2.resize(resultSize);
 
-        publicKey = getPublicKey(privateKey);
-
         return toHex(signature2);
     } catch (const std::exception &e) {
         throwErrTyped(TypeErrors::DONT_SIGN, std::string("dont sign ") + e.what());
+    } catch (const Exception &e) {
+        throwErrTyped(TypeErrors::DONT_SIGN, std::string("dont sign ") + e);
     }
 }
 
-bool Wallet::verify(const std::string &message, const std::string &signature, const std::string &publicKey) {
-    try {
-        const std::string signatureBinary = fromHex(signature);
+std::string Wallet::sign(const std::string &message, std::string &publicKey){
+    const std::string signature = signBinary(message);
+    publicKey = publicKeyHex;
+    return signature;
+}
 
-        CryptoPP::ECDSA<CryptoPP::ECP, CryptoPP::SHA256>::PublicKey publicK;
-        publicK.AccessGroupParameters().SetEncodeAsOID(true);
-        CryptoPP::StringSource sss(publicKey, true, new CryptoPP::HexDecoder());
-        publicK.Load(sss);
+static Secp256r1PublicKeyPtr parsePublicKeyHex(const std::string &publicKey) {
+    return parseSecp256r1PublicKey(fromHex(publicKey));
+}
 
-        CryptoPP::ECDSA<CryptoPP::ECP, CryptoPP::SHA256>::Verifier verifier(publicK);
+static bool verifySignature(const std::string &message, const std::string &signature, const Secp256r1PublicKey &publicKey) {
+    const std::string signatureBinary = fromHex(signature);
 
-        std::string signature2(64, 0);
-        const size_t resultSize = CryptoPP::DSAConvertSignatureFormat(
-            (byte*)signature2.data(), signature2.size(), CryptoPP::DSASignatureFormat::DSA_P1363,
-            (const byte*)signatureBinary.data(), signatureBinary.size(), CryptoPP::DSASignatureFormat::DSA_DER
-        );
-        signature2.resize(resultSize);
+    std::string signature2(64, 0);
+    const size_t resultSize = CryptoPP::DSAConvertSignatureFormat(
+        (byte*)signature2.data(), signature2.size(), CryptoPP::DSASignatureFormat::DSA_P1363,
+        (const byte*)signatureBinary.data(), signatureBinary.size(), CryptoPP::DSASignatureFormat::DSA_DER
+    );
+    signature2.resize(resultSize);
 
-        CryptoPP::StringSource ss2(message + signature2, true,
-            new CryptoPP::SignatureVerificationFilter(
-                verifier, nullptr, CryptoPP::SignatureVerificationFilter::THROW_EXCEPTION
-           )
-        );
+    return verifySecp256r1(publicKey, message, signature2);
+}
 
-        return true;
+bool Wallet::verify(const std::string &message, const std::string &signature, const std::string &publicKey) {
+    try {
+        return verifySignature(message, signature, *parsePublicKeyHex(publicKey));
     } catch (const std::exception &e) {
         return false;
+    } catch (const Exception &e) {
+        return false;
+    }
+}
+
+std::vector<bool> Wallet::verifyBatch(const std::vector<VerifyParams> &items, size_t maxThreads) {
+    std::map<std::string, Secp256r1PublicKeyPtr> publicKeys;
+    for (const VerifyParams &item: items) {
+        auto found = publicKeys.find(item.publicKey);
+        if (found == publicKeys.end()) {
+            Secp256r1PublicKeyPtr key;
+            try {
+                key = parsePublicKeyHex(item.publicKey);
+            } catch (const std::exception &e) {
+                // Оставляем nullptr, подписи с этим ключом невалидны
+            } catch (const Exception &e) {
+            }
+            publicKeys.emplace(item.publicKey, key);
+        }
     }
+
+    // std::vector<bool> нельзя писать из нескольких потоков
+    std::vector<char> results(items.size(), false);
+    ThreadPool::shared().parallelFor(items.size(), [&](size_t i) {
+        const Secp256r1PublicKeyPtr &key = publicKeys.at(items[i].publicKey);
+        if (key == nullptr) {
+            return;
+        }
+        try {
+            results[i] = verifySignature(items[i].message, items[i].signature, *key);
+        } catch (const std::exception &e) {
+        } catch (const Exception &e) {
+        }
+    }, maxThreads);
+
+    return std::vector<bool>(results.begin(), results.end());
 }
 
 std::string Wallet::genTx(const std::string &toAddress, uint64_t value, uint64_t fee, uint64_t nonce, const std::string &dataHex) {
@@ -309,6 +377,23 @@ void Wallet::sign(const std::string &toAddress, uint64_t value, uint64_t fee, ui
     txHex = toHex(txBinary);
 }
 
+std::vector<Wallet::SignedTx> Wallet::signBatch(const std::vector<TxParams> &txs, std::string &publicKey, size_t maxThreads) const {
+    std::vector<std::string> txsBinary;
+    txsBinary.reserve(txs.size());
+    for (const TxParams &tx: txs) {
+        txsBinary.emplace_back(genTx(tx.toAddress, tx.value, tx.fee, tx.nonce, tx.dataHex));
+    }
+
+    std::vector<SignedTx> result(txs.size());
+    ThreadPool::shared().parallelFor(txsBinary.size(), [&](size_t i) {
+        result[i].signature = signBinary(txsBinary[i]);
+        result[i].txHex = toHex(txsBinary[i]);
+    }, maxThreads);
+
+    publicKey = publicKeyHex;
+    return result;
+}
+
 std::string Wallet::genDataDelegateHex(bool isDelegate, uint64_t value) {
     return toHex(std::string("{\"method\":\"") + (isDelegate ? "delegate" : "undelegate") + "\",\"value\":\"" + std::to_string(value) + "\"}");
 }
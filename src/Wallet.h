@@ -7,6 +7,8 @@
 
 #include <cryptopp/eccrypto.h>
 
+#include "SecureMemory.h"
+
 class Wallet {
 public:
 
@@ -22,6 +24,9 @@ public:
 
     static std::vector<std::pair<QString, QString>> getAllWalletsInFolder(const QString &folder);
 
+    // Разбирает один файл папки кошельков. false, если файл не кошелек
+    static bool parseWalletFile(const QString &folder, const QString &file, std::pair<QString, QString> &wallet);
+
     static std::string getPrivateKey(const QString &folder, const std::string &addr, bool isCompact, bool isTMH);
 
     static void savePrivateKey(const QString &folder, const std::string &data, const std::string &password);
@@ -39,18 +44,49 @@ public:
 
     static std::string encryptMessage(const std::string &publicKeyHex, const std::string &message);
 
+    struct TxParams {
+        std::string toAddress;
+        uint64_t value = 0;
+        uint64_t fee = 0;
+        uint64_t nonce = 0;
+        std::string dataHex;
+    };
+
+    struct SignedTx {
+        std::string txHex;
+        std::string signature;
+    };
+
+    struct VerifyParams {
+        std::string message;
+        std::string signature;
+        std::string publicKey;
+    };
+
 public:
 
     Wallet(const QString &folder, const std::string &name, const std::string &password);
 
+    // Ключ из сессии (KeySessions), без чтения файла и расшифровки
+    Wallet(const QString &folder, const std::string &name, const SecureBytes &privateExponent);
+
+    SecureBytes getPrivateExponent() const;
+
     std::string sign(const std::string &message, std::string &publicKey);
 
     static bool verify(const std::string &message, const std::string &signature, const std::string &publicKey);
 
+    // Результат по каждой подписи. Публичные ключи разбираются один раз на пачку, проверка идет параллельно
+    static std::vector<bool> verifyBatch(const std::vector<VerifyParams> &items, size_t maxThreads = 0);
+
     static std::string genTx(const std::string &toAddress, uint64_t value, uint64_t fee, uint64_t nonce, const std::string &dataHex);
 
     void sign(const std::string &toAddress, uint64_t value, uint64_t fee, uint64_t nonce, const std::string &data, std::string &txHex, std::string &signature, std::string &publicKey);
 
+    // Подписывает все транзакции одним ключом. Транзакции проверяются до начала подписи,
+    // сама подпись идет параллельно на ThreadPool::shared()
+    std::vector<SignedTx> signBatch(const std::vector<TxParams> &txs, std::string &publicKey, size_t maxThreads = 0) const;
+
     static std::string genDataDelegateHex(bool isDelegate, uint64_t value);
 
     static std::string calcHash(const std::string &txHex);
@@ -63,10 +99,14 @@ private:
 
     static std::string createAddress(const std::string &publicKeyBinary);
 
+    std::string signBinary(const std::string &message) const;
+
 private:
 
     CryptoPP::ECDSA<CryptoPP::ECP, CryptoPP::SHA256>::PrivateKey privateKey;
 
+    std::string publicKeyHex;
+
     QString folder;
     std::string name;
 
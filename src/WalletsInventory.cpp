@@ -0,0 +1,95 @@
+#include "WalletsInventory.h"
+
+#include <set>
+
+#include <QDir>
+#include <QFileInfo>
+
+QString WalletsInventory::makeKey(const QString &folder) {
+    return QDir(folder).absolutePath();
+}
+
+void WalletsInventory::addFolder(const QString &folder, const FileParser &parser) {
+    Folder &f = folders[makeKey(folder)];
+    f.path = folder;
+    f.parser = parser;
+    f.files.clear();
+    update(folder);
+}
+
+void WalletsInventory::clear() {
+    folders.clear();
+}
+
+bool WalletsInventory::update(const QString &folder) {
+    const auto found = folders.find(makeKey(folder));
+    if (found == folders.end()) {
+        return false;
+    }
+    Folder &f = found->second;
+
+    const QDir dir(f.path);
+    const QFileInfoList allFiles = dir.entryInfoList(QDir::NoDotAndDotDot | QDir::System | QDir::Hidden  | QDir::AllDirs | QDir::Files, QDir::DirsFirst);
+    std::set<QString> current;
+    for (const QFileInfo &info: allFiles) {
+        current.insert(info.fileName());
+    }
+
+    bool isChanged = false;
+    for (auto iter = f.files.begin(); iter != f.files.end();) {
+        if (current.find(iter->first) == current.end()) {
+            iter = f.files.erase(iter);
+            isChanged = true;
+        } else {
+            ++iter;
+        }
+    }
+    for (const QFileInfo &info: allFiles) {
+        const QString fileName = info.fileName();
+        const auto found = f.files.find(fileName);
+        if (found != f.files.end() && found->second.modified == info.lastModified() && found->second.size == info.size()) {
+            continue;
+        }
+        File &file = f.files[fileName];
+        file = File();
+        file.modified = info.lastModified();
+        file.size = info.size();
+        try {
+            file.isWallet = f.parser(f.path, fileName, file.wallet);
+        } catch (...) {
+            file.error = std::current_exception();
+        }
+        isChanged = true;
+    }
+
+    if (isChanged) {
+        rebuild(f);
+    }
+    return true;
+}
+
+void WalletsInventory::rebuild(Folder &folder) {
+    folder.wallets.clear();
+    folder.error = nullptr;
+    for (const auto &pair: folder.files) {
+        const File &file = pair.second;
+        if (file.error != nullptr) {
+            if (folder.error == nullptr) {
+                folder.error = file.error;
+            }
+        } else if (file.isWallet) {
+            folder.wallets.emplace_back(file.wallet);
+        }
+    }
+}
+
+const WalletsInventory::Wallets& WalletsInventory::getWallets(const QString &folder) const {
+    const auto found = folders.find(makeKey(folder));
+    if (found == folders.end()) {
+        return empty;
+    }
+    if (found->second.error != nullptr) {
+        std::rethrow_exception(found->second.error);
+    }
+    return found->second.wallets;
+}
@@ -0,0 +1,69 @@
+#ifndef WALLETSINVENTORY_H
+#define WALLETSINVENTORY_H
+
+#include <map>
+#include <vector>
+#include <functional>
+#include <exception>
+
+#include <QString>
+#include <QDateTime>
+
+/*
+   Список кошельков по папкам валют. Папка читается целиком один раз, дальше по сигналам
+   QFileSystemWatcher перечитывается только список файлов, а разбираются лишь новые и измененные файлы.
+   */
+class WalletsInventory {
+public:
+
+    using Wallet = std::pair<QString, QString>;
+
+    using Wallets = std::vector<Wallet>;
+
+    // Разбирает один файл папки. false, если файл не кошелек
+    using FileParser = std::function<bool(const QString &folder, const QString &file, Wallet &wallet)>;
+
+public:
+
+    void addFolder(const QString &folder, const FileParser &parser);
+
+    void clear();
+
+    // false, если папка не отслеживается
+    bool update(const QString &folder);
+
+    // Если какой-то файл папки не разобрался, бросает его ошибку, как и полное сканирование
+    const Wallets& getWallets(const QString &folder) const;
+
+private:
+
+    struct File {
+        bool isWallet = false;
+        Wallet wallet;
+        std::exception_ptr error;
+        // Перезаписанный на месте файл разбирается заново
+        QDateTime modified;
+        qint64 size = 0;
+    };
+
+    struct Folder {
+        QString path;
+        FileParser parser;
+        // Упорядочены по имени файла
+        std::map<QString, File> files;
+        Wallets wallets;
+        std::exception_ptr error;
+    };
+
+    static QString makeKey(const QString &folder);
+
+    static void rebuild(Folder &folder);
+
+private:
+
+    std::map<QString, Folder> folders;
+
+    const Wallets empty;
+};
+
+#endif // WALLETSINVENTORY_H
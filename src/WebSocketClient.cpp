@@ -82,7 +82,7 @@ END_SLOT_WRAPPER
 
 void WebSocketClient::sendMessagesInternal() {
     if (isConnected) {
-        LOG << "Wss client send message " << (!messageQueue.empty() ? messageQueue.back() : "") << ". Count " << messageQueue.size();
+        LOG_DEBUG << "Wss client send message " << (!messageQueue.empty() ? messageQueue.back() : "") << ". Count " << messageQueue.size();
         for (const QString &m: messageQueue) {
             m_webSocket.sendTextMessage(m);
         }
@@ -108,7 +108,7 @@ END_SLOT_WRAPPER
 
 void WebSocketClient::onTextMessageReceived(QString message) {
 BEGIN_SLOT_WRAPPER
-    LOG << "Wss received " << message;
+    LOG_DEBUG << "Wss received " << message;
     emit messageReceived(message);
 END_SLOT_WRAPPER
 }
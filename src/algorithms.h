@@ -4,28 +4,84 @@
 #include <vector>
 #include <algorithm>
 #include <random>
+#include <unordered_map>
 
 #include "check.h"
 
+inline std::mt19937& getThreadRandomGenerator() {
+    thread_local std::mt19937 generator(std::random_device{}());
+    return generator;
+}
+
+/*
+   Выбирает count разных индексов из [0, size) частичной перетасовкой Фишера-Йетса.
+   Переставленные позиции хранятся в map, поэтому работает за O(count), а не за O(size).
+   chooser(begin, end) возвращает позицию из [begin, end) для очередного элемента
+*/
+template<class Chooser, class Visitor>
+void selectRandomIndices(size_t size, size_t count, const Chooser &chooser, const Visitor &visitor) {
+    std::unordered_map<size_t, size_t> swapped;
+    const auto at = [&swapped](size_t pos) {
+        const auto found = swapped.find(pos);
+        return found == swapped.end() ? pos : found->second;
+    };
+    for (size_t i = 0; i < count; i++) {
+        const size_t pos = chooser(i, size, at);
+        const size_t index = at(pos);
+        swapped[pos] = at(i);
+        visitor(index);
+    }
+}
+
 template<typename ReturnElement, typename Element, class ExtractInfo>
 std::vector<ReturnElement> getRandom(const std::vector<Element> &elements, size_t limit, size_t count, const ExtractInfo &extracter) {
     CHECK(count <= limit, "Incorrect count value");
 
-    std::random_device rd;
-    std::mt19937 g(rd());
-    std::vector<unsigned int> indices(std::min(limit, elements.size()));
-    std::iota(indices.begin(), indices.end(), 0);
-    std::shuffle(indices.begin(), indices.end(), g);
+    const size_t size = std::min(limit, elements.size());
+    std::mt19937 &g = getThreadRandomGenerator();
 
     std::vector<ReturnElement> result;
-    for (size_t i = 0; i < count; i++) {
-        result.emplace_back(extracter(elements[indices[i]]));
-    }
+    result.reserve(std::min(count, size));
+    selectRandomIndices(size, std::min(count, size), [&g](size_t begin, size_t end, const auto &/*at*/) {
+        return std::uniform_int_distribution<size_t>(begin, end - 1)(g);
+    }, [&](size_t index) {
+        result.emplace_back(extracter(elements[index]));
+    });
+    return result;
+}
+
+/*
+   Как getRandom, но из двух случайных кандидатов берется тот, у кого меньше cost (power of two choices).
+   Элементы с меньшим cost выпадают чаще, при этом нагрузка не уходит целиком на лучший
+*/
+template<typename ReturnElement, typename Element, class ExtractInfo, class Cost>
+std::vector<ReturnElement> getRandomTwoChoices(const std::vector<Element> &elements, size_t limit, size_t count, const ExtractInfo &extracter, const Cost &cost) {
+    CHECK(count <= limit, "Incorrect count value");
+
+    const size_t size = std::min(limit, elements.size());
+    std::mt19937 &g = getThreadRandomGenerator();
+
+    std::vector<ReturnElement> result;
+    result.reserve(std::min(count, size));
+    selectRandomIndices(size, std::min(count, size), [&](size_t begin, size_t end, const auto &at) {
+        const size_t first = std::uniform_int_distribution<size_t>(begin, end - 1)(g);
+        if (end - begin == 1) {
+            return first;
+        }
+        size_t second = std::uniform_int_distribution<size_t>(begin, end - 2)(g);
+        if (second >= first) {
+            second++;
+        }
+        return cost(elements[at(second)]) < cost(elements[at(first)]) ? second : first;
+    }, [&](size_t index) {
+        result.emplace_back(extracter(elements[index]));
+    });
     return result;
 }
 
 template<typename Element>
 Element getRandom(const std::vector<Element> &elements) {
+    CHECK(!elements.empty(), "Empty elements");
     return ::getRandom<Element>(elements, elements.size(), 1, [](const auto &element) {return element;})[0];
 }
 
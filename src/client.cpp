@@ -10,12 +10,17 @@ using namespace std::placeholders;
 #include <QNetworkRequest>
 #include <QNetworkReply>
 #include <QThread>
+#include <QTimer>
+#include <QFile>
+#include <QCryptographicHash>
 
 QT_USE_NAMESPACE
 
 const static QNetworkRequest::Attribute REQUEST_ID_FIELD = QNetworkRequest::Attribute(QNetworkRequest::User + 0);
-const static QNetworkRequest::Attribute TIME_BEGIN_FIELD = QNetworkRequest::Attribute(QNetworkRequest::User + 1);
-const static QNetworkRequest::Attribute TIMOUT_FIELD = QNetworkRequest::Attribute(QNetworkRequest::User + 2);
+
+SimpleClient::Download::Download() = default;
+
+SimpleClient::Download::~Download() = default;
 
 SimpleClient::SimpleClient() {
     manager = std::make_unique<QNetworkAccessManager>(this);
@@ -25,21 +30,19 @@ void SimpleClient::setParent(QObject *obj) {
     manager->setParent(obj);
 }
 
+const SimpleClient::ConnectionStatistic& SimpleClient::getConnectionStatistic() const {
+    return connectionStatistic;
+}
+
 void SimpleClient::moveToThread(QThread *thread) {
-    thread1 = thread;
     QObject::moveToThread(thread);
 }
 
-void SimpleClient::startTimer() {
-    if (timer == nullptr) {
-        timer = new QTimer(this);
-        CHECK(connect(timer, SIGNAL(timeout()), this, SLOT(onTimerEvent())), "not connect timeout");
-        if (thread1 != nullptr) {
-            CHECK(timer->connect(thread1, SIGNAL(finished()), SLOT(stop())), "not connect finished");
-        }
-        timer->setInterval(milliseconds(1s).count());
-        timer->start();
-    }
+static void setConnectionAttributes(QNetworkRequest &request) {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 8, 0)
+    // Qt договаривается о HTTP/2 через ALPN, поэтому он включается только для https
+    request.setAttribute(QNetworkRequest::HTTP2AllowedAttribute, true);
+#endif
 }
 
 static void addRequestId(QNetworkRequest &request, const std::string &id) {
@@ -55,104 +58,105 @@ static std::string getRequestId(QNetworkReply &reply) {
     return reply.request().attribute(REQUEST_ID_FIELD).toString().toStdString();
 }
 
-static void addBeginTime(QNetworkRequest &request, time_point tp) {
-    request.setAttribute(TIME_BEGIN_FIELD, QString::fromStdString(std::to_string(timePointToInt(tp))));
-}
-
-static bool isBeginTime(QNetworkReply &reply) {
-    return reply.request().attribute(TIME_BEGIN_FIELD).userType() == QMetaType::QString;
-}
-
-static time_point getBeginTime(QNetworkReply &reply) {
-    CHECK(isBeginTime(reply), "begin time field not set");
-    const size_t timeBegin = std::stoull(reply.request().attribute(TIME_BEGIN_FIELD).toString().toStdString());
-    const time_point timeBeginTp = intToTimePoint(timeBegin);
-    return timeBeginTp;
-}
-
-static void addTimeout(QNetworkRequest &request, milliseconds timeout) {
-    request.setAttribute(TIMOUT_FIELD, QString::fromStdString(std::to_string(timeout.count())));
-}
-
-static bool isTimeout(QNetworkReply &reply) {
-    return reply.request().attribute(TIMOUT_FIELD).userType() == QMetaType::QString;
-}
+const std::string SimpleClient::ERROR_BAD_REQUEST = "Error bad request";
 
-static milliseconds getTimeout(QNetworkReply &reply) {
-    CHECK(isTimeout(reply), "Timeout field not set");
-    return milliseconds(std::stol(reply.request().attribute(TIMOUT_FIELD).toString().toStdString()));
+void SimpleClient::trackRequest(QNetworkReply *reply) {
+    connectionStatistic.requests++;
+    CHECK(connect(reply, &QNetworkReply::finished, this, [this, reply]{
+        onRequestFinished(reply);
+    }), "not connect");
 }
 
-const std::string SimpleClient::ERROR_BAD_REQUEST = "Error bad request";
-
-void SimpleClient::onTimerEvent() {
+void SimpleClient::onRequestFinished(QNetworkReply *reply) {
 BEGIN_SLOT_WRAPPER
-    std::vector<std::reference_wrapper<QNetworkReply>> toDelete;
-    const time_point timeEnd = ::now();
-    for (auto &iter: requests) {
-        auto &reply = *iter.second;
-
-        if (isTimeout(reply)) {
-            const milliseconds timeout = getTimeout(reply);
-            const time_point timeBegin = getBeginTime(reply);
-            const milliseconds duration = std::chrono::duration_cast<milliseconds>(timeEnd - timeBegin);
-            if (duration >= timeout) {
-                LOG << "Timeout request";
-                toDelete.emplace_back(reply);
-            }
-        }
+    if (reply->error() != QNetworkReply::NoError) {
+        connectionStatistic.errors++;
     }
-
-    for (QNetworkReply& reply: toDelete) {
-        reply.abort();
+#if QT_VERSION >= QT_VERSION_CHECK(5, 8, 0)
+    if (reply->attribute(QNetworkRequest::HTTP2WasUsedAttribute).toBool()) {
+        connectionStatistic.http2++;
     }
+#endif
 END_SLOT_WRAPPER
 }
 
 void SimpleClient::sendMessagePost(const QUrl &url, const QString &message, const ClientCallback &callback) {
     const std::string requestId = std::to_string(id++);
 
-    startTimer();
-
     callbacks_[requestId] = callback;
     QNetworkRequest request(url);
     request.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
+    setConnectionAttributes(request);
     addRequestId(request, requestId);
     QNetworkReply* reply = manager->post(request, message.toUtf8());
     CHECK(connect(reply, SIGNAL(finished()), this, SLOT(onTextMessageReceived())), "not connect");
-    LOG << "post message sended";
+    trackRequest(reply);
+    LOG_DEBUG << "post message sended";
 }
 
 void SimpleClient::sendMessageGet(const QUrl &url, const ClientCallback &callback) {
     const std::string requestId = std::to_string(id++);
 
-    startTimer();
-
     callbacks_[requestId] = callback;
     QNetworkRequest request(url);
     request.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
+    setConnectionAttributes(request);
     addRequestId(request, requestId);
     QNetworkReply* reply = manager->get(request);
     CHECK(connect(reply, SIGNAL(finished()), this, SLOT(onTextMessageReceived())), "not connect");
-    LOG << "get message sended";
+    trackRequest(reply);
+    LOG_DEBUG << "get message sended";
 }
 
-void SimpleClient::ping(const QString &address, const PingCallback &callback, milliseconds timeout) {
+void SimpleClient::downloadFile(const QUrl &url, const QString &filePath, const DownloadCallback &callback) {
     const std::string requestId = std::to_string(id++);
 
-    startTimer();
+    auto download = std::make_unique<Download>();
+    download->callback = callback;
+    download->file = std::make_unique<QFile>(filePath);
+    CHECK(download->file->open(QIODevice::ReadWrite), "Not open file " + filePath.toStdString());
+    download->hash = std::make_unique<QCryptographicHash>(QCryptographicHash::Md5);
+    // Уже скачанная часть хэшируется заново, чтобы не хранить состояние хэша между запусками
+    CHECK(download->hash->addData(download->file.get()), "Error read file " + filePath.toStdString());
+    download->resumeFrom = download->file->size();
+
+    QNetworkRequest request(url);
+    setConnectionAttributes(request);
+    // Range считается по байтам файла, поэтому сжатие при передаче отключаем
+    request.setRawHeader("Accept-Encoding", "identity");
+    if (download->resumeFrom != 0) {
+        request.setRawHeader("Range", "bytes=" + QByteArray::number(download->resumeFrom) + "-");
+        LOG << "Resume download from " << download->resumeFrom;
+    }
+    addRequestId(request, requestId);
+    downloads[requestId] = std::move(download);
+    QNetworkReply* reply = manager->get(request);
+    CHECK(connect(reply, SIGNAL(readyRead()), this, SLOT(onDownloadReadyRead())), "not connect");
+    CHECK(connect(reply, SIGNAL(finished()), this, SLOT(onDownloadFinished())), "not connect");
+    trackRequest(reply);
+    LOG << "download started";
+}
+
+void SimpleClient::ping(const QString &address, const PingCallback &callback, milliseconds timeout) {
+    const std::string requestId = std::to_string(id++);
 
     pingCallbacks_[requestId] = std::bind(callback, address, _1, _2);
     QNetworkRequest request("http://" + address);
     request.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
-    const time_point time = ::now();
+    setConnectionAttributes(request);
     addRequestId(request, requestId);
-    addBeginTime(request, time);
-    addTimeout(request, timeout);
     QNetworkReply* reply = manager->get(request);
     CHECK(connect(reply, SIGNAL(finished()), this, SLOT(onPingReceived()), Qt::QueuedConnection), "not connect");
+    trackRequest(reply);
+    pingBegins[requestId] = ::now();
+    // Таймер живет, пока жив reply, поэтому отдельно его останавливать не нужно
+    QTimer::singleShot(static_cast<int>(timeout.count()), Qt::PreciseTimer, reply, [reply]{
+        if (!reply->isFinished()) {
+            LOG_DEBUG << "Timeout request";
+            reply->abort();
+        }
+    });
 
-    requests[requestId] = reply;
     //LOG << "ping message sended ";
 }
 
@@ -163,7 +167,6 @@ void SimpleClient::runCallback(Callbacks &callbacks, const std::string &id, Mess
     const auto callback = std::bind(foundCallback->second, std::forward<Message>(messages)...);
     emit callbackCall(callback);
     callbacks.erase(foundCallback);
-    requests.erase(id);
 }
 
 void SimpleClient::onPingReceived() {
@@ -171,7 +174,10 @@ BEGIN_SLOT_WRAPPER
     QNetworkReply *reply = qobject_cast<QNetworkReply *>(sender());
 
     const std::string requestId = getRequestId(*reply);
-    const time_point timeBegin = getBeginTime(*reply);
+    const auto foundBegin = pingBegins.find(requestId);
+    CHECK(foundBegin != pingBegins.end(), "not found ping on id " + requestId);
+    const time_point timeBegin = foundBegin->second;
+    pingBegins.erase(foundBegin);
     const time_point timeEnd = ::now();
     const milliseconds duration = std::chrono::duration_cast<milliseconds>(timeEnd - timeBegin);
 
@@ -206,3 +212,84 @@ BEGIN_SLOT_WRAPPER
     reply->deleteLater();
 END_SLOT_WRAPPER
 }
+
+void SimpleClient::writeDownloadChunk(QNetworkReply &reply, Download &download) {
+    if (!download.isStarted) {
+        download.isStarted = true;
+        const int status = reply.attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        if (status == 206) {
+            const QByteArray expectedRange = "bytes " + QByteArray::number(download.resumeFrom) + "-";
+            if (!reply.rawHeader("Content-Range").startsWith(expectedRange)) {
+                LOG << "Incorrect content range " << QString(reply.rawHeader("Content-Range"));
+                download.isFailed = true;
+            }
+        } else if (status == 200) {
+            // Сервер не поддерживает Range, качаем сначала
+            CHECK(download.file->resize(0) && download.file->seek(0), "Error resize file " + download.file->fileName().toStdString());
+            download.hash->reset();
+        } else {
+            download.isFailed = true;
+        }
+    }
+
+    const QByteArray chunk = reply.readAll();
+    if (download.isFailed || chunk.isEmpty()) {
+        return;
+    }
+    CHECK(download.file->write(chunk) == chunk.size(), "Error write file " + download.file->fileName().toStdString());
+    download.hash->addData(chunk);
+}
+
+void SimpleClient::onDownloadReadyRead() {
+BEGIN_SLOT_WRAPPER
+    QNetworkReply *reply = qobject_cast<QNetworkReply *>(sender());
+
+    const std::string requestId = getRequestId(*reply);
+    const auto found = downloads.find(requestId);
+    CHECK(found != downloads.end(), "not found download on id " + requestId);
+    Download &download = *found->second;
+    try {
+        writeDownloadChunk(*reply, download);
+    } catch (...) {
+        download.isFailed = true;
+        reply->abort();
+        throw;
+    }
+END_SLOT_WRAPPER
+}
+
+void SimpleClient::onDownloadFinished() {
+BEGIN_SLOT_WRAPPER
+    QNetworkReply *reply = qobject_cast<QNetworkReply *>(sender());
+    reply->deleteLater();
+
+    const std::string requestId = getRequestId(*reply);
+    const auto found = downloads.find(requestId);
+    CHECK(found != downloads.end(), "not found download on id " + requestId);
+    const std::unique_ptr<Download> download = std::move(found->second);
+    downloads.erase(found);
+
+    std::string result = ERROR_BAD_REQUEST;
+    // callback должен вызваться в любом случае, поэтому ошибки записи только логируем
+    slotWrapper([&]{
+        if (reply->error() == QNetworkReply::NoError) {
+            writeDownloadChunk(*reply, *download);
+            if (!download->isFailed) {
+                CHECK(download->file->flush(), "Error write file " + download->file->fileName().toStdString());
+                result = download->hash->result().toHex().toStdString();
+            } else {
+                // Сервер ответил не тем диапазоном, следующая попытка начнет сначала
+                download->file->resize(0);
+            }
+        } else {
+            LOG << reply->errorString().toStdString();
+            if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 416) {
+                download->file->resize(0);
+            }
+        }
+    });
+    download->file->close();
+
+    emit callbackCall(std::bind(download->callback, result));
+END_SLOT_WRAPPER
+}
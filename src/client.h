@@ -3,7 +3,6 @@
 
 #include <QObject>
 #include <QNetworkAccessManager>
-#include <QTimer>
 
 #include <memory>
 #include <functional>
@@ -12,12 +11,19 @@
 
 #include "duration.h"
 
+class QFile;
+class QNetworkReply;
+class QCryptographicHash;
+
 using ClientCallback = std::function<void(const std::string &response)>;
 
 using PingCallback = std::function<void(const QString &address, const milliseconds &time, const std::string &response)>;
 
 using ReturnCallback = std::function<void()>;
 
+// md5 скачанного файла в hex или SimpleClient::ERROR_BAD_REQUEST
+using DownloadCallback = std::function<void(const std::string &md5)>;
+
 /*
    На каждый поток должен быть один экземпляр класса.
    */
@@ -29,6 +35,26 @@ private:
 
     using PingCallbackInternal = std::function<void(const milliseconds &time, const std::string &response)>;
 
+    struct Download {
+        DownloadCallback callback;
+        std::unique_ptr<QFile> file;
+        std::unique_ptr<QCryptographicHash> hash;
+        qint64 resumeFrom = 0;
+        bool isStarted = false;
+        bool isFailed = false;
+
+        Download();
+        ~Download();
+    };
+
+public:
+
+    struct ConnectionStatistic {
+        size_t requests = 0;
+        size_t http2 = 0;
+        size_t errors = 0;
+    };
+
 public:
 
     static const std::string ERROR_BAD_REQUEST;
@@ -40,11 +66,17 @@ public:
     void sendMessagePost(const QUrl &url, const QString &message, const ClientCallback &callback);
     void sendMessageGet(const QUrl &url, const ClientCallback &callback);
 
+    // Ответ пишется в filePath по мере прихода, md5 считается на лету. Если filePath уже есть, он докачивается через Range.
+    // При ошибке файл остается на диске для следующей попытки
+    void downloadFile(const QUrl &url, const QString &filePath, const DownloadCallback &callback);
+
     // ping хорошо работает только с максимум одним одновременным запросом
     void ping(const QString &address, const PingCallback &callback, milliseconds timeout);
 
     void setParent(QObject *obj);
 
+    const ConnectionStatistic& getConnectionStatistic() const;
+
     void moveToThread(QThread *thread);
 
 Q_SIGNALS:
@@ -59,25 +91,31 @@ private Q_SLOTS:
 
     void onPingReceived();
 
-    void onTimerEvent();
+    void onDownloadReadyRead();
+
+    void onDownloadFinished();
 
 private:
 
     template<class Callbacks, typename... Message>
     void runCallback(Callbacks &callbacks, const std::string &id, Message&&... messages);
 
-    void startTimer();
+    void trackRequest(QNetworkReply *reply);
+
+    void onRequestFinished(QNetworkReply *reply);
+
+    void writeDownloadChunk(QNetworkReply &reply, Download &download);
 
 private:
     std::unique_ptr<QNetworkAccessManager> manager;
     std::unordered_map<std::string, ClientCallback> callbacks_;
     std::unordered_map<std::string, PingCallbackInternal> pingCallbacks_;
+    std::unordered_map<std::string, std::unique_ptr<Download>> downloads;
 
-    std::unordered_map<std::string, QNetworkReply*> requests;
-
-    QTimer* timer = nullptr;
+    // Время отправки пингов. Таймауты держат таймеры самих reply
+    std::unordered_map<std::string, time_point> pingBegins;
 
-    QThread *thread1 = nullptr;
+    ConnectionStatistic connectionStatistic;
 
     int id = 0;
 };
@@ -29,6 +29,16 @@ quint16 DnsPacket::generateId()
     return m_id;
 }
 
+void DnsPacket::setId(quint16 id)
+{
+    m_id = id;
+}
+
+quint16 DnsPacket::id() const
+{
+    return m_id;
+}
+
 void DnsPacket::addDomainName(const QString &domainName)
 {
     m_questions.append( DnsQuestion(domainName) );
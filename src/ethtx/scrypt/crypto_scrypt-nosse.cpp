@@ -36,17 +36,20 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <atomic>
+
 #include "sha256.h"
 #include "sysendian.h"
 
 #include "libscrypt.h"
+#include "crypto_scrypt_smix.h"
+#include "../../ThreadPool.h"
 
 static void blkcpy(void *, void *, size_t);
 static void blkxor(void *, void *, size_t);
 static void salsa20_8(uint32_t[16]);
 static void blockmix_salsa8(uint32_t *, uint32_t *, uint32_t *, size_t);
 static uint64_t integerify(void *, size_t);
-static void smix(uint8_t *, size_t, uint64_t, uint32_t *, uint32_t *);
 
 static void
 blkcpy(void * dest, void * src, size_t len)
@@ -162,16 +165,18 @@ integerify(void * B, size_t r)
 }
 
 /**
- * smix(B, r, N, V, XY):
+ * libscrypt_smix_nosse(B, r, N, V, XY):
  * Compute B = SMix_r(B, N).  The input B must be 128r bytes in length;
  * the temporary storage V must be 128rN bytes in length; the temporary
  * storage XY must be 256r + 64 bytes in length.  The value N must be a
  * power of 2 greater than 1.  The arrays B, V, and XY must be aligned to a
  * multiple of 64 bytes.
  */
-static void
-smix(uint8_t * B, size_t r, uint64_t N, uint32_t * V, uint32_t * XY)
+void
+libscrypt_smix_nosse(uint8_t * B, size_t r, uint64_t N, void * V0, void * XY0)
 {
+	uint32_t * V = (uint32_t *)V0;
+	uint32_t * XY = (uint32_t *)XY0;
 	uint32_t * X = XY;
 	uint32_t * Y = &XY[32 * r];
 	uint32_t * Z = &XY[64 * r];
@@ -220,6 +225,85 @@ smix(uint8_t * B, size_t r, uint64_t N, uint32_t * V, uint32_t * XY)
 		le32enc(&B[4 * k], X[k]);
 }
 
+/**
+ * region_alloc(len, base, use_mmap):
+ * Allocate len bytes aligned to 64 bytes; *base receives the pointer which
+ * must be passed to region_free.  Large V arrays come from mmap when
+ * available.  Return NULL on error.
+ */
+static void *
+region_alloc(size_t len, void ** base, int use_mmap)
+{
+#ifdef MAP_ANON
+	if (use_mmap) {
+		if ((*base = mmap(NULL, len, PROT_READ | PROT_WRITE,
+#ifdef MAP_NOCORE
+		    MAP_ANON | MAP_PRIVATE | MAP_NOCORE,
+#else
+		    MAP_ANON | MAP_PRIVATE,
+#endif
+		    -1, 0)) == MAP_FAILED)
+			return (NULL);
+		return (*base);
+	}
+#else
+	(void)use_mmap;
+#endif
+#ifdef HAVE_POSIX_MEMALIGN
+	if ((errno = posix_memalign(base, 64, len)) != 0)
+		return (NULL);
+	return (*base);
+#else
+	if ((*base = malloc(len + 63)) == NULL)
+		return (NULL);
+	return ((void *)(((uintptr_t)(*base) + 63) & ~ (uintptr_t)(63)));
+#endif
+}
+
+static void
+region_free(void * base, size_t len, int use_mmap)
+{
+#ifdef MAP_ANON
+	if (use_mmap) {
+		munmap(base, len);
+		return;
+	}
+#else
+	(void)use_mmap;
+	(void)len;
+#endif
+	free(base);
+}
+
+/**
+ * smix_lanes(B, r, N, p, backend, lanes, next, V, XY):
+ * Run SMix on the blocks of B in units claimed from *next until all of them
+ * are taken.  Unit u < p / lanes covers blocks u * lanes ... u * lanes +
+ * lanes - 1, the remaining units cover one block each.  Return the number
+ * of units processed.
+ */
+static uint32_t
+smix_lanes(uint8_t * B, size_t r, uint64_t N, uint32_t p,
+    const struct libscrypt_smix_backend & backend, uint32_t lanes,
+    std::atomic<uint32_t> & next, void * V, void * XY)
+{
+	const uint32_t groups = p / lanes;
+	const uint32_t units = groups + p % lanes;
+	uint32_t done = 0;
+	uint32_t u;
+
+	while ((u = next.fetch_add(1)) < units) {
+		/* 3: B_i <-- MF(B_i, N) */
+		if (u < groups && lanes > 1)
+			backend.smix(&B[(size_t)u * lanes * 128 * r], r, N, V, XY);
+		else
+			backend.smix1(&B[((size_t)groups * lanes + u - groups) * 128 * r],
+			    r, N, V, XY);
+		done++;
+	}
+	return (done);
+}
+
 /**
  * crypto_scrypt(passwd, passwdlen, salt, saltlen, N, r, p, buf, buflen):
  * Compute scrypt(passwd[0 .. passwdlen - 1], salt[0 .. saltlen - 1], N, r,
@@ -234,11 +318,16 @@ libscrypt_scrypt(const uint8_t * passwd, size_t passwdlen,
     const uint8_t * salt, size_t saltlen, uint64_t N, uint32_t r, uint32_t p,
     uint8_t * buf, size_t buflen)
 {
-	void * B0, * V0, * XY0;
+	void * B0;
 	uint8_t * B;
-	uint32_t * V;
-	uint32_t * XY;
-	uint32_t i;
+	struct libscrypt_smix_backend backend;
+	uint32_t lanes;
+	uint32_t units;
+	uint32_t threads;
+	size_t Vsize;
+	size_t XYsize;
+	std::atomic<uint32_t> next(0);
+	std::atomic<uint32_t> done(0);
 
 	/* Sanity-check parameters. */
 #if SIZE_MAX > UINT32_MAX
@@ -268,73 +357,71 @@ libscrypt_scrypt(const uint8_t * passwd, size_t passwdlen,
 		goto err0;
 	}
 
+	/* Multi-lane backends need one V per lane; fall back to their
+	 * single-block variant when p or the address space is too small. */
+	backend = libscrypt_smix_backend_get();
+	lanes = backend.lanes;
+	if (lanes > p || r > SIZE_MAX / 256 / lanes ||
+	    N > SIZE_MAX / 128 / r / lanes)
+		lanes = 1;
+	Vsize = 128 * r * N * lanes;
+	XYsize = (256 * r + 64) * lanes;
+
+	/* Every worker owns its V and XY, so the number of workers is bounded
+	 * by the configured thread count and by the memory budget. */
+	units = p / lanes + p % lanes;
+	threads = libscrypt_get_max_threads();
+	if (threads > units)
+		threads = units;
+	if (threads > 1 && (Vsize + XYsize) > LIBSCRYPT_PARALLEL_MEMORY / threads) {
+		threads = (uint32_t)(LIBSCRYPT_PARALLEL_MEMORY / (Vsize + XYsize));
+		if (threads == 0)
+			threads = 1;
+	}
+
 	/* Allocate memory. */
-#ifdef HAVE_POSIX_MEMALIGN
-	if ((errno = posix_memalign(&B0, 64, 128 * r * p)) != 0)
+	if ((B = (uint8_t *)region_alloc(128 * r * p, &B0, 0)) == NULL)
 		goto err0;
-	B = (uint8_t *)(B0);
-	if ((errno = posix_memalign(&XY0, 64, 256 * r + 64)) != 0)
-		goto err1;
-	XY = (uint32_t *)(XY0);
-#ifndef MAP_ANON
-	if ((errno = posix_memalign(&V0, 64, 128 * r * N)) != 0)
-		goto err2;
-	V = (uint32_t *)(V0);
-#endif
-#else
-	if ((B0 = malloc(128 * r * p + 63)) == NULL)
-		goto err0;
-	B = (uint8_t *)(((uintptr_t)(B0) + 63) & ~ (uintptr_t)(63));
-	if ((XY0 = malloc(256 * r + 64 + 63)) == NULL)
-		goto err1;
-	XY = (uint32_t *)(((uintptr_t)(XY0) + 63) & ~ (uintptr_t)(63));
-#ifndef MAP_ANON
-	if ((V0 = malloc(128 * r * N + 63)) == NULL)
-		goto err2;
-	V = (uint32_t *)(((uintptr_t)(V0) + 63) & ~ (uintptr_t)(63));
-#endif
-#endif
-#ifdef MAP_ANON
-	if ((V0 = mmap(NULL, 128 * r * N, PROT_READ | PROT_WRITE,
-#ifdef MAP_NOCORE
-	    MAP_ANON | MAP_PRIVATE | MAP_NOCORE,
-#else
-	    MAP_ANON | MAP_PRIVATE,
-#endif
-	    -1, 0)) == MAP_FAILED)
-		goto err2;
-	V = (uint32_t *)(V0);
-#endif
 
 	/* 1: (B_0 ... B_{p-1}) <-- PBKDF2(P, S, 1, p * MFLen) */
 	libscrypt_PBKDF2_SHA256(passwd, passwdlen, salt, saltlen, 1, B, p * 128 * r);
 
 	/* 2: for i = 0 to p - 1 do */
-	for (i = 0; i < p; i++) {
-		/* 3: B_i <-- MF(B_i, N) */
-		smix(&B[i * 128 * r], r, N, V, XY);
+	try {
+		ThreadPool::shared().parallelFor(threads, [&](size_t) {
+			void * V0, * XY0;
+			void * V, * XY;
+
+			if ((XY = region_alloc(XYsize, &XY0, 0)) == NULL)
+				return;
+			if ((V = region_alloc(Vsize, &V0, 1)) == NULL) {
+				region_free(XY0, XYsize, 0);
+				return;
+			}
+			done += smix_lanes(B, r, N, p, backend, lanes, next, V, XY);
+			region_free(V0, Vsize, 1);
+			region_free(XY0, XYsize, 0);
+		}, threads);
+	} catch (...) {
+		done = 0;
+	}
+	/* Workers that could not allocate their V leave units to the others. */
+	if (done != units) {
+		errno = ENOMEM;
+		goto err1;
 	}
 
 	/* 5: DK <-- PBKDF2(P, B, 1, dkLen) */
 	libscrypt_PBKDF2_SHA256(passwd, passwdlen, B, p * 128 * r, 1, buf, buflen);
 
 	/* Free memory. */
-#ifdef MAP_ANON
-	if (munmap(V0, 128 * r * N))
-		goto err2;
-#else
-	free(V0);
-#endif
-	free(XY0);
-	free(B0);
+	region_free(B0, 128 * r * p, 0);
 
 	/* Success! */
 	return (0);
 
-err2:
-	free(XY0);
 err1:
-	free(B0);
+	region_free(B0, 128 * r * p, 0);
 err0:
 	/* Failure! */
 	return (-1);
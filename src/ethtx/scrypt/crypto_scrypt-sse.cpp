@@ -0,0 +1,437 @@
+/*-
+ * Copyright 2009 Colin Percival
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file was originally written by Colin Percival as part of the Tarsnap
+ * online backup system.
+ *
+ * SSE2 and AVX2 SMix backends.  Both keep each 64-byte salsa20/8 block in
+ * the "diagonal" word order of the Tarsnap SSE code, so the column and row
+ * rounds are plain vector operations plus three lane shuffles.  The AVX2
+ * backend runs two independent blocks B_i, B_{i+1} side by side: the low
+ * 128-bit half of every ymm belongs to the first block, the high half to the
+ * second.  Only this file is compiled with vector instructions; callers go
+ * through the CPUID dispatch in crypto_scrypt_smix.cpp.
+ */
+
+#include "crypto_scrypt_smix.h"
+
+#ifdef LIBSCRYPT_X86
+
+#include <emmintrin.h>
+#include <immintrin.h>
+
+#include "sysendian.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define TARGET_SSE2
+#define TARGET_AVX2
+#define ALWAYS_INLINE __forceinline
+#endif
+
+/* Word i of the diagonal layout holds word (i * 5) mod 16 of the block. */
+#define DIAG(i) (((i) * 5) & 15)
+
+/*
+ * Four double rounds of salsa20/8 on the state X0..X3, parameterised by the
+ * vector operations so the same schedule serves xmm and ymm registers.
+ */
+#define SALSA20_8_ROUNDS(ADD, XOR, SLL, SRL, SHUF, X0, X1, X2, X3)	\
+	do {								\
+		int i_;							\
+		for (i_ = 0; i_ < 8; i_ += 2) {				\
+			/* Operate on "columns". */			\
+			T = ADD(X0, X3);				\
+			X1 = XOR(X1, SLL(T, 7));			\
+			X1 = XOR(X1, SRL(T, 25));			\
+			T = ADD(X1, X0);				\
+			X2 = XOR(X2, SLL(T, 9));			\
+			X2 = XOR(X2, SRL(T, 23));			\
+			T = ADD(X2, X1);				\
+			X3 = XOR(X3, SLL(T, 13));			\
+			X3 = XOR(X3, SRL(T, 19));			\
+			T = ADD(X3, X2);				\
+			X0 = XOR(X0, SLL(T, 18));			\
+			X0 = XOR(X0, SRL(T, 14));			\
+									\
+			/* Rearrange data. */				\
+			X1 = SHUF(X1, 0x93);				\
+			X2 = SHUF(X2, 0x4E);				\
+			X3 = SHUF(X3, 0x39);				\
+									\
+			/* Operate on "rows". */			\
+			T = ADD(X0, X1);				\
+			X3 = XOR(X3, SLL(T, 7));			\
+			X3 = XOR(X3, SRL(T, 25));			\
+			T = ADD(X3, X0);				\
+			X2 = XOR(X2, SLL(T, 9));			\
+			X2 = XOR(X2, SRL(T, 23));			\
+			T = ADD(X2, X3);				\
+			X1 = XOR(X1, SLL(T, 13));			\
+			X1 = XOR(X1, SRL(T, 19));			\
+			T = ADD(X1, X2);				\
+			X0 = XOR(X0, SLL(T, 18));			\
+			X0 = XOR(X0, SRL(T, 14));			\
+									\
+			/* Rearrange data. */				\
+			X1 = SHUF(X1, 0x39);				\
+			X2 = SHUF(X2, 0x4E);				\
+			X3 = SHUF(X3, 0x93);				\
+		}							\
+	} while (0)
+
+/* ---------------------------------------------------------------- SSE2 */
+
+TARGET_SSE2 static ALWAYS_INLINE void
+salsa20_8_sse2(__m128i & B0, __m128i & B1, __m128i & B2, __m128i & B3)
+{
+	__m128i X0 = B0, X1 = B1, X2 = B2, X3 = B3;
+	__m128i T;
+
+	SALSA20_8_ROUNDS(_mm_add_epi32, _mm_xor_si128, _mm_slli_epi32,
+	    _mm_srli_epi32, _mm_shuffle_epi32, X0, X1, X2, X3);
+
+	B0 = _mm_add_epi32(B0, X0);
+	B1 = _mm_add_epi32(B1, X1);
+	B2 = _mm_add_epi32(B2, X2);
+	B3 = _mm_add_epi32(B3, X3);
+}
+
+/**
+ * blockmix_salsa8_sse2(Bin, Vxor, Vcopy, Bout, r):
+ * Compute Bout = BlockMix_{salsa20/8, r}(Bin \xor Vxor), where Vxor may be
+ * NULL.  When Vcopy is not NULL Bin is also stored there, which folds step 3
+ * of SMix into the same pass over memory.  The 64-byte state X stays in
+ * registers for the whole call.
+ */
+TARGET_SSE2 static ALWAYS_INLINE void
+blockmix_salsa8_sse2(const __m128i * Bin, const __m128i * Vxor,
+    __m128i * Vcopy, __m128i * Bout, size_t r)
+{
+	__m128i X0, X1, X2, X3;
+	__m128i B0, B1, B2, B3;
+	size_t i, k;
+
+	/* 1: X <-- B_{2r - 1} */
+	k = 8 * r - 4;
+	X0 = Bin[k + 0];
+	X1 = Bin[k + 1];
+	X2 = Bin[k + 2];
+	X3 = Bin[k + 3];
+	if (Vxor != NULL) {
+		X0 = _mm_xor_si128(X0, Vxor[k + 0]);
+		X1 = _mm_xor_si128(X1, Vxor[k + 1]);
+		X2 = _mm_xor_si128(X2, Vxor[k + 2]);
+		X3 = _mm_xor_si128(X3, Vxor[k + 3]);
+	}
+
+	/* 2: for i = 0 to 2r - 1 do */
+	for (i = 0; i < 2 * r; i++) {
+		k = 4 * i;
+		B0 = Bin[k + 0];
+		B1 = Bin[k + 1];
+		B2 = Bin[k + 2];
+		B3 = Bin[k + 3];
+		if (Vcopy != NULL) {
+			Vcopy[k + 0] = B0;
+			Vcopy[k + 1] = B1;
+			Vcopy[k + 2] = B2;
+			Vcopy[k + 3] = B3;
+		}
+		if (Vxor != NULL) {
+			B0 = _mm_xor_si128(B0, Vxor[k + 0]);
+			B1 = _mm_xor_si128(B1, Vxor[k + 1]);
+			B2 = _mm_xor_si128(B2, Vxor[k + 2]);
+			B3 = _mm_xor_si128(B3, Vxor[k + 3]);
+		}
+
+		/* 3: X <-- H(X \xor B_i) */
+		X0 = _mm_xor_si128(X0, B0);
+		X1 = _mm_xor_si128(X1, B1);
+		X2 = _mm_xor_si128(X2, B2);
+		X3 = _mm_xor_si128(X3, B3);
+		salsa20_8_sse2(X0, X1, X2, X3);
+
+		/* 4: Y_i <-- X */
+		/* 6: B' <-- (Y_0, Y_2 ... Y_{2r-2}, Y_1, Y_3 ... Y_{2r-1}) */
+		k = 4 * ((i >> 1) + (i & 1) * r);
+		Bout[k + 0] = X0;
+		Bout[k + 1] = X1;
+		Bout[k + 2] = X2;
+		Bout[k + 3] = X3;
+	}
+}
+
+/**
+ * integerify_sse2(B, r):
+ * Return the result of parsing B_{2r-1} as a little-endian integer.  Words
+ * 0 and 1 of the block live at diagonal positions 0 and 13.
+ */
+static inline uint64_t
+integerify_sse2(const void * B, size_t r)
+{
+	const uint32_t * X = (const uint32_t *)((uintptr_t)(B) + (2 * r - 1) * 64);
+
+	return (((uint64_t)(X[13]) << 32) + X[0]);
+}
+
+/**
+ * libscrypt_smix_sse2(B, r, N, V, XY):
+ * Compute B = SMix_r(B, N).  Same contract as the scalar smix: B is 128r
+ * bytes, V is 128rN bytes, XY is 256r + 64 bytes, all 64-byte aligned.
+ */
+TARGET_SSE2 void
+libscrypt_smix_sse2(uint8_t * B, size_t r, uint64_t N, void * V, void * XY)
+{
+	__m128i * X = (__m128i *)XY;
+	__m128i * Y = (__m128i *)((uintptr_t)(XY) + 128 * r);
+	__m128i * V128 = (__m128i *)V;
+	uint32_t * X32 = (uint32_t *)X;
+	const size_t stride = 8 * r;
+	uint64_t i;
+	uint64_t j;
+	size_t k;
+	size_t w;
+
+	/* 1: X <-- B */
+	for (k = 0; k < 2 * r; k++) {
+		for (w = 0; w < 16; w++)
+			X32[k * 16 + w] = le32dec(&B[(k * 16 + DIAG(w)) * 4]);
+	}
+
+	/* 2: for i = 0 to N - 1 do */
+	for (i = 0; i < N; i += 2) {
+		/* 3: V_i <-- X; 4: X <-- H(X) */
+		blockmix_salsa8_sse2(X, NULL, &V128[i * stride], Y, r);
+		blockmix_salsa8_sse2(Y, NULL, &V128[(i + 1) * stride], X, r);
+	}
+
+	/* 6: for i = 0 to N - 1 do */
+	for (i = 0; i < N; i += 2) {
+		/* 7: j <-- Integerify(X) mod N */
+		/* 8: X <-- H(X \xor V_j) */
+		j = integerify_sse2(X, r) & (N - 1);
+		blockmix_salsa8_sse2(X, &V128[j * stride], NULL, Y, r);
+
+		j = integerify_sse2(Y, r) & (N - 1);
+		blockmix_salsa8_sse2(Y, &V128[j * stride], NULL, X, r);
+	}
+
+	/* 10: B' <-- X */
+	for (k = 0; k < 2 * r; k++) {
+		for (w = 0; w < 16; w++)
+			le32enc(&B[(k * 16 + DIAG(w)) * 4], X32[k * 16 + w]);
+	}
+}
+
+/* ---------------------------------------------------------------- AVX2 */
+
+/*
+ * Two-lane layout: element m of a 2r-block array is one ymm holding
+ * diagonal words 4(m%4)..4(m%4)+3 of block m/4 for lane 0 in its low half
+ * and the same words for lane 1 in its high half.  Each lane keeps its own
+ * contiguous V (lane 1 starts 128rN bytes after lane 0), so the random reads
+ * of step 8 touch exactly the cache lines the scalar code would.
+ */
+
+#define LANE_WORD(k, w, lane) ((((k) * 4 + ((w) >> 2)) * 8) + (lane) * 4 + ((w) & 3))
+
+TARGET_AVX2 static ALWAYS_INLINE void
+salsa20_8_avx2(__m256i & B0, __m256i & B1, __m256i & B2, __m256i & B3)
+{
+	__m256i X0 = B0, X1 = B1, X2 = B2, X3 = B3;
+	__m256i T;
+
+	SALSA20_8_ROUNDS(_mm256_add_epi32, _mm256_xor_si256, _mm256_slli_epi32,
+	    _mm256_srli_epi32, _mm256_shuffle_epi32, X0, X1, X2, X3);
+
+	B0 = _mm256_add_epi32(B0, X0);
+	B1 = _mm256_add_epi32(B1, X1);
+	B2 = _mm256_add_epi32(B2, X2);
+	B3 = _mm256_add_epi32(B3, X3);
+}
+
+/* Gather element m of V_ja (lane 0) and V_jb (lane 1). */
+TARGET_AVX2 static ALWAYS_INLINE __m256i
+load_lanes_avx2(const __m128i * Va, const __m128i * Vb)
+{
+	return _mm256_inserti128_si256(
+	    _mm256_castsi128_si256(_mm_load_si128(Va)), _mm_load_si128(Vb), 1);
+}
+
+/* Scatter element m back to the per-lane V rows. */
+TARGET_AVX2 static ALWAYS_INLINE void
+store_lanes_avx2(__m128i * Va, __m128i * Vb, __m256i x)
+{
+	_mm_store_si128(Va, _mm256_castsi256_si128(x));
+	_mm_store_si128(Vb, _mm256_extracti128_si256(x, 1));
+}
+
+/**
+ * blockmix_salsa8_avx2(Bin, Xa, Xb, Ca, Cb, Bout, r):
+ * Two-lane BlockMix.  When Xa/Xb are not NULL, lane 0 input is xored with
+ * the V row Xa and lane 1 input with Xb; when Ca/Cb are not NULL the input
+ * is also copied to those V rows.
+ */
+TARGET_AVX2 static ALWAYS_INLINE void
+blockmix_salsa8_avx2(const __m256i * Bin, const __m128i * Xa,
+    const __m128i * Xb, __m128i * Ca, __m128i * Cb, __m256i * Bout, size_t r)
+{
+	__m256i X0, X1, X2, X3;
+	__m256i B0, B1, B2, B3;
+	size_t i, k;
+
+	/* 1: X <-- B_{2r - 1} */
+	k = 8 * r - 4;
+	X0 = Bin[k + 0];
+	X1 = Bin[k + 1];
+	X2 = Bin[k + 2];
+	X3 = Bin[k + 3];
+	if (Xa != NULL) {
+		X0 = _mm256_xor_si256(X0, load_lanes_avx2(&Xa[k + 0], &Xb[k + 0]));
+		X1 = _mm256_xor_si256(X1, load_lanes_avx2(&Xa[k + 1], &Xb[k + 1]));
+		X2 = _mm256_xor_si256(X2, load_lanes_avx2(&Xa[k + 2], &Xb[k + 2]));
+		X3 = _mm256_xor_si256(X3, load_lanes_avx2(&Xa[k + 3], &Xb[k + 3]));
+	}
+
+	/* 2: for i = 0 to 2r - 1 do */
+	for (i = 0; i < 2 * r; i++) {
+		k = 4 * i;
+		B0 = Bin[k + 0];
+		B1 = Bin[k + 1];
+		B2 = Bin[k + 2];
+		B3 = Bin[k + 3];
+		if (Ca != NULL) {
+			store_lanes_avx2(&Ca[k + 0], &Cb[k + 0], B0);
+			store_lanes_avx2(&Ca[k + 1], &Cb[k + 1], B1);
+			store_lanes_avx2(&Ca[k + 2], &Cb[k + 2], B2);
+			store_lanes_avx2(&Ca[k + 3], &Cb[k + 3], B3);
+		}
+		if (Xa != NULL) {
+			B0 = _mm256_xor_si256(B0, load_lanes_avx2(&Xa[k + 0], &Xb[k + 0]));
+			B1 = _mm256_xor_si256(B1, load_lanes_avx2(&Xa[k + 1], &Xb[k + 1]));
+			B2 = _mm256_xor_si256(B2, load_lanes_avx2(&Xa[k + 2], &Xb[k + 2]));
+			B3 = _mm256_xor_si256(B3, load_lanes_avx2(&Xa[k + 3], &Xb[k + 3]));
+		}
+
+		/* 3: X <-- H(X \xor B_i) */
+		X0 = _mm256_xor_si256(X0, B0);
+		X1 = _mm256_xor_si256(X1, B1);
+		X2 = _mm256_xor_si256(X2, B2);
+		X3 = _mm256_xor_si256(X3, B3);
+		salsa20_8_avx2(X0, X1, X2, X3);
+
+		/* 4: Y_i <-- X */
+		/* 6: B' <-- (Y_0, Y_2 ... Y_{2r-2}, Y_1, Y_3 ... Y_{2r-1}) */
+		k = 4 * ((i >> 1) + (i & 1) * r);
+		Bout[k + 0] = X0;
+		Bout[k + 1] = X1;
+		Bout[k + 2] = X2;
+		Bout[k + 3] = X3;
+	}
+}
+
+static inline uint64_t
+integerify_avx2(const void * B, size_t r, int lane)
+{
+	const uint32_t * X = (const uint32_t *)B;
+	const size_t k = 2 * r - 1;
+
+	return (((uint64_t)(X[LANE_WORD(k, 13, lane)]) << 32) +
+	    X[LANE_WORD(k, 0, lane)]);
+}
+
+/**
+ * libscrypt_smix_avx2_x2(B, r, N, V, XY):
+ * Compute B_0 = SMix_r(B_0, N) and B_1 = SMix_r(B_1, N) for the two
+ * consecutive 128r-byte blocks at B.  V must be 256rN bytes, XY must be
+ * 512r + 128 bytes, all 64-byte aligned.
+ */
+TARGET_AVX2 void
+libscrypt_smix_avx2_x2(uint8_t * B, size_t r, uint64_t N, void * V, void * XY)
+{
+	__m256i * X = (__m256i *)XY;
+	__m256i * Y = (__m256i *)((uintptr_t)(XY) + 256 * r);
+	__m128i * Va = (__m128i *)V;
+	__m128i * Vb = (__m128i *)((uintptr_t)(V) + 128 * r * N);
+	uint32_t * X32 = (uint32_t *)X;
+	const size_t stride = 8 * r;
+	uint64_t i;
+	uint64_t ja, jb;
+	size_t k;
+	size_t w;
+	int lane;
+
+	/* 1: X <-- B */
+	for (lane = 0; lane < 2; lane++) {
+		const uint8_t * Bl = &B[lane * 128 * r];
+		for (k = 0; k < 2 * r; k++) {
+			for (w = 0; w < 16; w++) {
+				X32[LANE_WORD(k, w, lane)] =
+				    le32dec(&Bl[(k * 16 + DIAG(w)) * 4]);
+			}
+		}
+	}
+
+	/* 2: for i = 0 to N - 1 do */
+	for (i = 0; i < N; i += 2) {
+		/* 3: V_i <-- X; 4: X <-- H(X) */
+		blockmix_salsa8_avx2(X, NULL, NULL,
+		    &Va[i * stride], &Vb[i * stride], Y, r);
+		blockmix_salsa8_avx2(Y, NULL, NULL,
+		    &Va[(i + 1) * stride], &Vb[(i + 1) * stride], X, r);
+	}
+
+	/* 6: for i = 0 to N - 1 do */
+	for (i = 0; i < N; i += 2) {
+		/* 7: j <-- Integerify(X) mod N */
+		/* 8: X <-- H(X \xor V_j) */
+		ja = integerify_avx2(X, r, 0) & (N - 1);
+		jb = integerify_avx2(X, r, 1) & (N - 1);
+		blockmix_salsa8_avx2(X, &Va[ja * stride], &Vb[jb * stride],
+		    NULL, NULL, Y, r);
+
+		ja = integerify_avx2(Y, r, 0) & (N - 1);
+		jb = integerify_avx2(Y, r, 1) & (N - 1);
+		blockmix_salsa8_avx2(Y, &Va[ja * stride], &Vb[jb * stride],
+		    NULL, NULL, X, r);
+	}
+
+	/* 10: B' <-- X */
+	for (lane = 0; lane < 2; lane++) {
+		uint8_t * Bl = &B[lane * 128 * r];
+		for (k = 0; k < 2 * r; k++) {
+			for (w = 0; w < 16; w++) {
+				le32enc(&Bl[(k * 16 + DIAG(w)) * 4],
+				    X32[LANE_WORD(k, w, lane)]);
+			}
+		}
+	}
+}
+
+#endif /* LIBSCRYPT_X86 */
@@ -0,0 +1,203 @@
+/*-
+ * Runtime configuration of libscrypt_scrypt: SMix backend and worker count.
+ */
+
+#include <errno.h>
+
+#include <atomic>
+#include <thread>
+
+#include "crypto_scrypt_smix.h"
+#include "libscrypt.h"
+
+#ifdef LIBSCRYPT_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <immintrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace {
+
+struct CpuFeatures {
+	bool sse2 = false;
+	bool avx2 = false;
+};
+
+#ifdef LIBSCRYPT_X86
+void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4])
+{
+#ifdef _MSC_VER
+	int r[4];
+	__cpuidex(r, (int)leaf, (int)subleaf);
+	for (int i = 0; i < 4; i++)
+		regs[i] = (uint32_t)r[i];
+#else
+	__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+uint64_t xgetbv0()
+{
+#ifdef _MSC_VER
+	return _xgetbv(0);
+#else
+	uint32_t eax, edx;
+	__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return ((uint64_t)edx << 32) | eax;
+#endif
+}
+#endif
+
+CpuFeatures detectCpu()
+{
+	CpuFeatures features;
+#ifdef LIBSCRYPT_X86
+	uint32_t regs[4];
+	cpuid(0, 0, regs);
+	const uint32_t maxLeaf = regs[0];
+	if (maxLeaf < 1)
+		return features;
+	cpuid(1, 0, regs);
+	features.sse2 = (regs[3] & (1u << 26)) != 0;
+	const bool osxsave = (regs[2] & (1u << 27)) != 0;
+	const bool avx = (regs[2] & (1u << 28)) != 0;
+	/* The OS must save ymm state on context switch (XCR0 bits 1 and 2). */
+	const bool ymmEnabled = osxsave && avx && (xgetbv0() & 0x6) == 0x6;
+	if (maxLeaf >= 7 && ymmEnabled) {
+		cpuid(7, 0, regs);
+		features.avx2 = (regs[1] & (1u << 5)) != 0;
+	}
+#endif
+	return features;
+}
+
+const CpuFeatures & cpuFeatures()
+{
+	static const CpuFeatures features = detectCpu();
+	return features;
+}
+
+bool isSupported(int kernel)
+{
+	switch (kernel) {
+	case LIBSCRYPT_KERNEL_NOSSE:
+		return true;
+	case LIBSCRYPT_KERNEL_SSE2:
+		return cpuFeatures().sse2;
+	case LIBSCRYPT_KERNEL_AVX2:
+		return cpuFeatures().sse2 && cpuFeatures().avx2;
+	default:
+		return false;
+	}
+}
+
+int bestKernel()
+{
+	if (isSupported(LIBSCRYPT_KERNEL_AVX2))
+		return LIBSCRYPT_KERNEL_AVX2;
+	if (isSupported(LIBSCRYPT_KERNEL_SSE2))
+		return LIBSCRYPT_KERNEL_SSE2;
+	return LIBSCRYPT_KERNEL_NOSSE;
+}
+
+std::atomic<int> selectedKernel(LIBSCRYPT_KERNEL_AUTO);
+
+std::atomic<uint32_t> maxThreads(0);
+
+int currentKernel()
+{
+	int kernel = selectedKernel.load(std::memory_order_relaxed);
+	if (kernel == LIBSCRYPT_KERNEL_AUTO) {
+		kernel = bestKernel();
+		selectedKernel.store(kernel, std::memory_order_relaxed);
+	}
+	return kernel;
+}
+
+}
+
+int
+libscrypt_set_kernel(int kernel)
+{
+	if (kernel == LIBSCRYPT_KERNEL_AUTO)
+		kernel = bestKernel();
+	if (!isSupported(kernel)) {
+		errno = EINVAL;
+		return (-1);
+	}
+	selectedKernel.store(kernel, std::memory_order_relaxed);
+	return (0);
+}
+
+int
+libscrypt_get_kernel(void)
+{
+	return currentKernel();
+}
+
+int
+libscrypt_kernel_supported(int kernel)
+{
+	return isSupported(kernel) ? 1 : 0;
+}
+
+void
+libscrypt_set_max_threads(uint32_t threads)
+{
+	maxThreads.store(threads, std::memory_order_relaxed);
+}
+
+uint32_t
+libscrypt_get_max_threads(void)
+{
+	const uint32_t threads = maxThreads.load(std::memory_order_relaxed);
+	if (threads != 0)
+		return threads;
+	const unsigned int hardware = std::thread::hardware_concurrency();
+	return hardware != 0 ? hardware : 1;
+}
+
+const char *
+libscrypt_kernel_name(int kernel)
+{
+	switch (kernel) {
+	case LIBSCRYPT_KERNEL_AUTO:
+		return "auto";
+	case LIBSCRYPT_KERNEL_NOSSE:
+		return "nosse";
+	case LIBSCRYPT_KERNEL_SSE2:
+		return "sse2";
+	case LIBSCRYPT_KERNEL_AVX2:
+		return "avx2";
+	default:
+		return "unknown";
+	}
+}
+
+struct libscrypt_smix_backend
+libscrypt_smix_backend_get(void)
+{
+	struct libscrypt_smix_backend backend;
+	backend.lanes = 1;
+	backend.smix = libscrypt_smix_nosse;
+	backend.smix1 = libscrypt_smix_nosse;
+#ifdef LIBSCRYPT_X86
+	switch (currentKernel()) {
+	case LIBSCRYPT_KERNEL_AVX2:
+		backend.lanes = 2;
+		backend.smix = libscrypt_smix_avx2_x2;
+		backend.smix1 = libscrypt_smix_sse2;
+		break;
+	case LIBSCRYPT_KERNEL_SSE2:
+		backend.smix = libscrypt_smix_sse2;
+		backend.smix1 = libscrypt_smix_sse2;
+		break;
+	default:
+		break;
+	}
+#endif
+	return backend;
+}
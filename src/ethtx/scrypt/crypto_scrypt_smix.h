@@ -0,0 +1,42 @@
+/*-
+ * Internal interface between libscrypt_scrypt and its SMix backends.
+ */
+#ifndef _CRYPTO_SCRYPT_SMIX_H_
+#define _CRYPTO_SCRYPT_SMIX_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LIBSCRYPT_X86 1
+#endif
+
+/**
+ * smix(B, r, N, V, XY):
+ * Compute B_l = SMix_r(B_l, N) for the `lanes` consecutive 128r-byte blocks
+ * of B handled by the backend.  V must be lanes * 128rN bytes in length, XY
+ * must be lanes * (256r + 64) bytes in length; B, V and XY must be aligned
+ * to a multiple of 64 bytes.
+ */
+typedef void (*libscrypt_smix_t)(uint8_t * B, size_t r, uint64_t N, void * V,
+    void * XY);
+
+struct libscrypt_smix_backend {
+	/* Number of independent blocks processed by one smix call. */
+	uint32_t lanes;
+	libscrypt_smix_t smix;
+	/* Single-block variant used when fewer than `lanes` blocks remain. */
+	libscrypt_smix_t smix1;
+};
+
+void libscrypt_smix_nosse(uint8_t *, size_t, uint64_t, void *, void *);
+#ifdef LIBSCRYPT_X86
+void libscrypt_smix_sse2(uint8_t *, size_t, uint64_t, void *, void *);
+/* Two interleaved blocks per call: salsa20/8 of both runs in one ymm. */
+void libscrypt_smix_avx2_x2(uint8_t *, size_t, uint64_t, void *, void *);
+#endif
+
+/* Backend currently selected by libscrypt_set_kernel() / CPUID. */
+struct libscrypt_smix_backend libscrypt_smix_backend_get(void);
+
+#endif /* !_CRYPTO_SCRYPT_SMIX_H_ */
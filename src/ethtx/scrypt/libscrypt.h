@@ -29,6 +29,38 @@ extern "C"{
 int libscrypt_scrypt(const uint8_t *, size_t, const uint8_t *, size_t, uint64_t,
     uint32_t, uint32_t, /*@out@*/ uint8_t *, size_t);
 
+/* SMix implementations libscrypt_scrypt can run on.  All of them produce
+ * identical output; AUTO picks the fastest one the CPU supports (checked
+ * via CPUID on first use). AVX2 processes two of the p blocks at once and
+ * therefore needs 2 * 128rN bytes of V when p > 1.
+ */
+#define LIBSCRYPT_KERNEL_AUTO 0
+#define LIBSCRYPT_KERNEL_NOSSE 1
+#define LIBSCRYPT_KERNEL_SSE2 2
+#define LIBSCRYPT_KERNEL_AVX2 3
+
+/* Forces the SMix implementation. Returns 0 on success, or -1 if the CPU
+ * does not support it */
+int libscrypt_set_kernel(int kernel);
+
+/* Returns the SMix implementation currently in use (never AUTO) */
+int libscrypt_get_kernel(void);
+
+/* Returns 1 if the CPU can run the given SMix implementation */
+int libscrypt_kernel_supported(int kernel);
+
+const char *libscrypt_kernel_name(int kernel);
+
+/* The p blocks of libscrypt_scrypt are independent and are processed
+ * concurrently on the shared ThreadPool. Each worker owns a 128rN-byte V,
+ * so the worker count is also limited by LIBSCRYPT_PARALLEL_MEMORY.
+ * 0 restores the default (number of hardware threads), 1 disables
+ * parallelism.
+ */
+void libscrypt_set_max_threads(uint32_t threads);
+
+uint32_t libscrypt_get_max_threads(void);
+
 /* Converts a series of input parameters to a MCF form for storage */
 int libscrypt_mcf(uint32_t N, uint32_t r, uint32_t p, const char *salt,
 	const char *hash, char *mcf);
@@ -59,6 +91,8 @@ int libscrypt_check(char *mcf, const char *password);
 			  * a blocker for insane defines
 			  */
 #define SCRYPT_SALT_LEN 16 /* This is just a recommended size */
+#define LIBSCRYPT_PARALLEL_MEMORY ((size_t)512 * 1024 * 1024) /* Upper bound
+ * for the V arrays of concurrent workers of one libscrypt_scrypt call */
 /* Standard MCF is:
    $s1 Identifier, three chars
    $0e0810 Work order and separator, six chars
@@ -7,17 +7,12 @@
 #include <cstring>
 
 #include "check.h"
+#include "Codecs.h"
 
 std::string DumpToHexString(const uint8_t* dump, uint32_t dumpsize)
 {
-    std::string res;
-    const char hex[] = "0123456789abcdef";
-    for (size_t i = 0; i < dumpsize; ++i)
-    {
-        unsigned char c = static_cast<unsigned char>(dump[i]);
-        res += hex[c >> 4];
-        res += hex[c & 0xf];
-    }
+    std::string res(hexEncodedSize(dumpsize), 0);
+    encodeHex((const char*)dump, dumpsize, &res[0]);
     return res;
 }
 
@@ -28,40 +23,23 @@ std::string DumpToHexString(const std::string &str)
 
 std::string HexStringToDump(const std::string& hexstr)
 {
-    std::string decoded = "";
-    unsigned char a,b,c;
-    a = b = c = 0;
-
-    for (int cnt = (int)hexstr.size()-1; cnt >= 0;)
+    // Нечетная строка дополняется нулем слева
+    const size_t odd = hexstr.size() % 2;
+    std::string decoded(hexDecodedSize(hexstr.size() + odd), 0);
+    bool isValid = true;
+    if (odd != 0)
     {
-        a = hexstr.at(cnt);
-        --cnt;
-        b = (cnt >= 0) ? hexstr.at(cnt) : '0';
-        --cnt;
-        if (a >= '0' && a <= '9') {
-            a = a - '0';
-        } else if (a >= 'a' && a <= 'f') {
-            a = a - 'a' + 10;
-        } else if (a >= 'A' && a <= 'F') {
-            a = a - 'A' + 10;
-        } else {
-            throwErr("Incorrect hex str " + hexstr);
-        }
-
-        if (b >= '0' && b <= '9') {
-            b = b - '0';
-        } else if (b >= 'a' && b <= 'f') {
-            b = b - 'a' + 10;
-        } else if (b >= 'A' && b <= 'F') {
-            b = b - 'A' + 10;
-        } else {
-            throwErr("Incorrect hex str " + hexstr);
-        }
-
-        c = (b << 4) + a;
-        decoded.insert(decoded.begin(), c);
+        const char first[2] = {'0', hexstr[0]};
+        isValid = decodeHex(first, 2, &decoded[0]);
+    }
+    if (isValid)
+    {
+        isValid = decodeHex(hexstr.data() + odd, hexstr.size() - odd, &decoded[odd]);
+    }
+    if (!isValid)
+    {
+        throwErr("Incorrect hex str " + hexstr);
     }
-
     return decoded;
 }
 
@@ -0,0 +1,102 @@
+#include "htmlsschemehandler.h"
+
+#include <QWebEngineUrlRequestJob>
+#include <QBuffer>
+#include <QUrl>
+#include <QtGlobal>
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+#include <QWebEngineUrlScheme>
+#endif
+
+#include "HtmlPack.h"
+#include "PagesMappings.h"
+#include "HtmlManifest.h"
+#include "check.h"
+#include "Log.h"
+#include "utils.h"
+#include "ThreadPool.h"
+
+namespace {
+
+// Держит упаковку, пока QtWebEngine читает ответ
+class PackReply : public QBuffer {
+public:
+
+    PackReply(const std::shared_ptr<HtmlPack> &pack, const QByteArray &data, QObject *parent)
+        : QBuffer(parent)
+        , pack(pack)
+    {
+        setData(data);
+        open(QIODevice::ReadOnly);
+    }
+
+private:
+
+    const std::shared_ptr<HtmlPack> pack;
+};
+
+}
+
+QByteArray HtmlsSchemeHandler::scheme() {
+    return QUrl(HTMLS_URL).scheme().toLatin1();
+}
+
+void HtmlsSchemeHandler::registerScheme() {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+    QWebEngineUrlScheme htmlsScheme(scheme());
+    htmlsScheme.setSyntax(QWebEngineUrlScheme::Syntax::Host);
+    htmlsScheme.setFlags(QWebEngineUrlScheme::SecureScheme | QWebEngineUrlScheme::LocalAccessAllowed);
+    QWebEngineUrlScheme::registerScheme(htmlsScheme);
+#endif
+}
+
+bool HtmlsSchemeHandler::isSupported() {
+    return QT_VERSION >= QT_VERSION_CHECK(5, 12, 0);
+}
+
+HtmlsSchemeHandler::HtmlsSchemeHandler(QObject *parent)
+    : QWebEngineUrlSchemeHandler(parent)
+{}
+
+bool HtmlsSchemeHandler::setVersionDir(const QString &versionDir) {
+    if (pack != nullptr && isPathEquals(this->versionDir, versionDir)) {
+        return true;
+    }
+    this->versionDir = versionDir;
+    pack = HtmlPack::open(versionDir);
+    if (pack == nullptr && isExistFolder(versionDir) && !isPathEquals(buildingDir, versionDir)) {
+        // Версия установлена до включения упаковок. Упаковка собирается в фоне,
+        // а пока страницы открываются с диска. Отображается она при следующей загрузке
+        buildingDir = versionDir;
+        ThreadPool::shared().post([versionDir]{
+            try {
+                HtmlPack::write(versionDir, loadHtmlManifest(versionDir));
+                LOG << "Html pack created " << versionDir;
+            } catch (const Exception &e) {
+                LOG << "Html pack not created: " << e;
+            } catch (...) {
+                LOG << "Html pack not created: unknown error";
+            }
+        });
+    }
+    return pack != nullptr;
+}
+
+void HtmlsSchemeHandler::requestStarted(QWebEngineUrlRequestJob *job) {
+    const QUrl url = job->requestUrl();
+    QString path = url.path();
+    if (path.startsWith('/')) {
+        path = path.mid(1);
+    }
+
+    QByteArray data;
+    if (pack == nullptr || !pack->find(path, data)) {
+        LOG << "HtmlsSchemeHandler: not found " << url.toString();
+        job->fail(QWebEngineUrlRequestJob::UrlNotFound);
+        return;
+    }
+
+    const QByteArray mime = mimeDatabase.mimeTypeForFile(path, QMimeDatabase::MatchExtension).name().toLatin1();
+    job->reply(mime, new PackReply(pack, data, job));
+}
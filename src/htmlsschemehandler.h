@@ -0,0 +1,44 @@
+#ifndef HTMLSSCHEMEHANDLER_H
+#define HTMLSSCHEMEHANDLER_H
+
+#include <memory>
+
+#include <QWebEngineUrlSchemeHandler>
+#include <QMimeDatabase>
+
+class QWebEngineUrlRequestJob;
+class HtmlPack;
+
+/*
+   Отдает страницы интерфейса по HTMLS_URL из упаковки версии (HtmlPack), а не из файлов на диске.
+   */
+class HtmlsSchemeHandler : public QWebEngineUrlSchemeHandler
+{
+public:
+
+    // Схему надо зарегистрировать до создания QApplication, иначе не будут работать относительные ссылки
+    static void registerScheme();
+
+    static bool isSupported();
+
+    static QByteArray scheme();
+
+    explicit HtmlsSchemeHandler(QObject *parent = nullptr);
+
+    // false, если у версии нет упаковки. Недостающая упаковка собирается в фоне
+    bool setVersionDir(const QString &versionDir);
+
+    void requestStarted(QWebEngineUrlRequestJob *job) override;
+
+private:
+
+    QString versionDir;
+
+    QString buildingDir;
+
+    std::shared_ptr<HtmlPack> pack;
+
+    QMimeDatabase mimeDatabase;
+};
+
+#endif // HTMLSSCHEMEHANDLER_H
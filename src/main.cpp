@@ -27,6 +27,7 @@
 #include "JavascriptWrapper.h"
 #include "TypedException.h"
 #include "Paths.h"
+#include "htmlsschemehandler.h"
 
 #ifndef _WIN32
 static void crash_handler(int sig) {
@@ -68,6 +69,10 @@ int main(int argc, char *argv[]) {
         format.setColorSpace(QSurfaceFormat::sRGBColorSpace);
         QSurfaceFormat::setDefaultFormat(format);
 
+        if (isHtmlsSchemeSetup) {
+            HtmlsSchemeHandler::registerScheme();
+        }
+
         QApplication app(argc, argv);
         initLog();
         InitOpenSSL();
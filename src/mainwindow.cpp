@@ -29,6 +29,8 @@
 #include "SlotWrapper.h"
 
 #include "mhurlschemehandler.h"
+#include "htmlsschemehandler.h"
+#include "platform.h"
 
 #include "machine_uid.h"
 
@@ -59,8 +61,14 @@ MainWindow::MainWindow(JavascriptWrapper &jsWrapper, QWidget *parent)
     ui->setupUi(this);
 
     shemeHandler = new MHUrlSchemeHandler(this);
+    shemeHandler->setHedging(isMhHedgingSetup);
     QWebEngineProfile::defaultProfile()->installUrlSchemeHandler(QByteArray("mh"), shemeHandler);
 
+    if (isHtmlsSchemeSetup && HtmlsSchemeHandler::isSupported()) {
+        htmlsSchemeHandler = new HtmlsSchemeHandler(this);
+        QWebEngineProfile::defaultProfile()->installUrlSchemeHandler(HtmlsSchemeHandler::scheme(), htmlsSchemeHandler);
+    }
+
     hardwareId = QString::fromStdString(::getMachineUid());
 
     configureMenu();
@@ -104,7 +112,7 @@ MainWindow::MainWindow(JavascriptWrapper &jsWrapper, QWidget *parent)
 void MainWindow::onUpdateMhsReferences() {
 BEGIN_SLOT_WRAPPER
     client.sendMessageGet(QUrl("http://dns.metahash.io/"), [this](const std::string &response) {
-        LOG << "Set mappings mh " << response;
+        LOG_DEBUG << "Set mappings mh " << response;
         pagesMappings.setMappingsMh(QString::fromStdString(response));
     });
 END_SLOT_WRAPPER
@@ -386,7 +394,12 @@ void MainWindow::loadUrl(const QString &page) {
 
 void MainWindow::loadFile(const QString &pageName) {
     LOG << "Reload. Last version " << lastHtmls.lastVersion;
-    loadUrl("file:///" + makePath(lastHtmls.htmlsRootPath, lastHtmls.folderName, lastHtmls.lastVersion, pageName));
+    const QString versionDir = makePath(lastHtmls.htmlsRootPath, lastHtmls.folderName, lastHtmls.lastVersion);
+    if (htmlsSchemeHandler != nullptr && htmlsSchemeHandler->setVersionDir(versionDir)) {
+        loadUrl(HTMLS_URL + pageName);
+    } else {
+        loadUrl("file:///" + makePath(versionDir, pageName));
+    }
 }
 
 void MainWindow::addElementToHistoryAndCommandLine(const QString &text, bool isAddToHistory, bool isReplace) {
@@ -480,7 +493,7 @@ END_SLOT_WRAPPER
 
 void MainWindow::onSetMappings(QString mapping) {
 BEGIN_SLOT_WRAPPER
-    LOG << "Set mappings " << mapping;
+    LOG_DEBUG << "Set mappings " << mapping;
     pagesMappings.setMappings(mapping);
 END_SLOT_WRAPPER
 }
@@ -495,8 +508,10 @@ void MainWindow::showExpanded() {
     show();
 }
 
-QString MainWindow::getServerIp(const QString &text) const {
-    QString ip = pagesMappings.getIp(text);
-    QUrl url(ip);
-    return url.host();
+std::vector<QString> MainWindow::getServerIps(const QString &text) const {
+    std::vector<QString> result;
+    for (const QString &ip: pagesMappings.getIps(text)) {
+        result.emplace_back(QUrl(ip).host());
+    }
+    return result;
 }
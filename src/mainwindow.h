@@ -20,6 +20,7 @@
 class WebSocketClient;
 class JavascriptWrapper;
 class MHUrlSchemeHandler;
+class HtmlsSchemeHandler;
 
 namespace Ui {
     class MainWindow;
@@ -50,7 +51,7 @@ public:
 
     void showExpanded();
 
-    QString getServerIp(const QString &text) const;
+    std::vector<QString> getServerIps(const QString &text) const;
 
 private:
 
@@ -108,6 +109,8 @@ private:
 
     MHUrlSchemeHandler *shemeHandler = nullptr;
 
+    HtmlsSchemeHandler *htmlsSchemeHandler = nullptr;
+
     std::unique_ptr<Ui::MainWindow> ui;
 
     std::unique_ptr<QWebChannel> channel;
@@ -4,52 +4,277 @@
 #include <QNetworkAccessManager>
 #include <QNetworkRequest>
 #include <QNetworkReply>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QBuffer>
+#include <QTimer>
+
+#include <map>
+#include <vector>
+#include <algorithm>
 
 #include "mainwindow.h"
 #include "SlotWrapper.h"
 #include "check.h"
+#include "Paths.h"
+
+const static size_t MAX_MEMORY_CACHE_SIZE = 32 * 1024 * 1024;
+const static size_t MAX_DISK_CACHE_SIZE = 256 * 1024 * 1024;
+
+const static int HEADERS_TIMEOUT_MS = 5000;
+
+const static size_t MAX_LATENCIES = 128;
+const static size_t MIN_LATENCIES_FOR_HEDGE = 16;
+const static qint64 DEFAULT_HEDGE_DELAY_MS = 1000;
+const static qint64 MIN_HEDGE_DELAY_MS = 50;
+const static qint64 MAX_HEDGE_DELAY_MS = 3000;
+
+struct MHUrlSchemeHandler::Request {
+    QPointer<QWebEngineUrlRequestJob> job;
+
+    QUrl url;
+
+    QString host;
+
+    std::vector<QString> ips;
+
+    size_t nextIp = 0;
+
+    // Запросы в полете и время их отправки
+    std::map<QNetworkReply*, qint64> attempts;
+
+    QNetworkReply *winner = nullptr;
+
+    QElapsedTimer timer;
+
+    QString cacheKey;
+
+    bool isCached = false;
+
+    HttpCache::Entry cached;
+
+    bool isFinished = false;
+};
+
+static QByteArray getMime(QNetworkReply &reply) {
+    QVariant contentMimeType = reply.header(QNetworkRequest::ContentTypeHeader);
+    QByteArray mime = contentMimeType.toByteArray();
+    const int pos = mime.indexOf(';');
+    if (pos != -1) {
+        mime = mime.left(pos);
+    }
+    return mime;
+}
+
+static void replyFromCache(QWebEngineUrlRequestJob *job, const HttpCache::Entry &entry) {
+    QBuffer *buffer = new QBuffer(job);
+    buffer->setData(entry.body);
+    buffer->open(QIODevice::ReadOnly);
+    job->reply(entry.mime, buffer);
+}
+
+static int getStatus(QNetworkReply &reply) {
+    return reply.attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+}
+
+// 5xx и обрывы соединения считаем проблемой ноды и пробуем следующую
+static bool isNodeAnswered(QNetworkReply &reply) {
+    const int status = getStatus(reply);
+    return status > 0 && status < 500;
+}
 
 MHUrlSchemeHandler::MHUrlSchemeHandler(QObject *parent)
     : QWebEngineUrlSchemeHandler(parent)
 {
     m_manager = new QNetworkAccessManager(this);
+    cache = std::make_unique<HttpCache>(getMhCachePath(), MAX_MEMORY_CACHE_SIZE, MAX_DISK_CACHE_SIZE);
 }
 
 void MHUrlSchemeHandler::setLog() {
     isLog = true;
 }
 
+void MHUrlSchemeHandler::setHedging(bool isHedging) {
+    this->isHedging = isHedging;
+}
+
 void MHUrlSchemeHandler::requestStarted(QWebEngineUrlRequestJob *job)
 {
-    const QUrl url = job->requestUrl();
-    const QString host = url.host();
+    const auto request = std::make_shared<Request>();
+    request->job = job;
+    request->url = job->requestUrl();
+    request->host = request->url.host();
+
+    // Запрос к ноде всегда уходит GET'ом, поэтому кэшируем только GET страницы
+    const QUrl &url = request->url;
+    const bool isCacheable = job->requestMethod() == "GET";
+    request->cacheKey = isCacheable ? HttpCache::makeKey(request->host, url.path(QUrl::FullyEncoded) + (url.hasQuery() ? "?" + url.query(QUrl::FullyEncoded) : "")) : QString();
+    request->isCached = isCacheable && cache->find(request->cacheKey, request->cached);
+    if (request->isCached && request->cached.isFresh()) {
+        statistic.hits++;
+        replyFromCache(job, request->cached);
+        return;
+    }
 
-    QString ip;
     MainWindow *win = qobject_cast<MainWindow *>(parent());
     CHECK(win, "mainwin cast");
-    ip = win->getServerIp(url.toString());
-    QUrl newurl(url);
-    newurl.setScheme(QStringLiteral("http"));
-    newurl.setHost(ip);
+    request->ips = win->getServerIps(url.toString());
     if (isLog) {
-        LOG << "MHUrlSchemeHandler: " << url.toString() << " " << ip << " " << host << " " << newurl.toString();
+        LOG << "MHUrlSchemeHandler: " << url.toString() << " " << request->host << " " << request->ips.size() << " ips " << (request->ips.empty() ? QString() : request->ips.front());
+        LOG << "MHUrlSchemeHandler statistic: hits " << statistic.hits << ", revalidated " << statistic.revalidated << ", misses " << statistic.misses << ", retries " << statistic.retries << ", hedged " << statistic.hedged << ", streamed " << statistic.streamed;
         isLog = false;
     }
+
+    request->timer.start();
+    if (!sendAttempt(request)) {
+        job->fail(QWebEngineUrlRequestJob::UrlNotFound);
+        return;
+    }
+
+    if (isHedging && request->ips.size() > 1) {
+        QTimer::singleShot(static_cast<int>(getHedgeDelay()), job, [this, request]{
+            BEGIN_SLOT_WRAPPER
+            if (request->winner != nullptr || request->isFinished) {
+                return;
+            }
+            if (sendAttempt(request)) {
+                statistic.hedged++;
+            }
+            END_SLOT_WRAPPER
+        });
+    }
+}
+
+bool MHUrlSchemeHandler::sendAttempt(const std::shared_ptr<Request> &request)
+{
+    if (request->job.isNull() || request->nextIp >= request->ips.size()) {
+        return false;
+    }
+    const QString &ip = request->ips[request->nextIp];
+    request->nextIp++;
+
+    QUrl newurl(request->url);
+    newurl.setScheme(QStringLiteral("http"));
+    newurl.setHost(ip);
     QNetworkRequest req(newurl);
-    req.setRawHeader(QByteArray("Host"), host.toUtf8());
+    req.setRawHeader(QByteArray("Host"), request->host.toUtf8());
+    if (request->isCached) {
+        if (!request->cached.etag.isEmpty()) {
+            req.setRawHeader(QByteArray("If-None-Match"), request->cached.etag);
+        }
+        if (!request->cached.lastModified.isEmpty()) {
+            req.setRawHeader(QByteArray("If-Modified-Since"), request->cached.lastModified);
+        }
+    }
+
     QNetworkReply *reply = m_manager->get(req);
-    reply->setParent(job);
-    CHECK(connect(reply, &QNetworkReply::finished, this, &MHUrlSchemeHandler::onRequestFinished), "connect fail");
+    reply->setParent(request->job.data());
+    request->attempts[reply] = request->timer.elapsed();
+    CHECK(connect(reply, &QNetworkReply::metaDataChanged, this, [this, request, reply]{
+        onAttemptHeaders(request, reply);
+    }), "connect fail");
+    CHECK(connect(reply, &QNetworkReply::finished, this, [this, request, reply]{
+        onAttemptFinished(request, reply);
+    }), "connect fail");
+    QTimer::singleShot(HEADERS_TIMEOUT_MS, reply, [request, reply]{
+        if (request->winner == nullptr && !reply->isFinished()) {
+            reply->abort();
+        }
+    });
+    return true;
 }
 
-void MHUrlSchemeHandler::onRequestFinished()
+void MHUrlSchemeHandler::chooseWinner(const std::shared_ptr<Request> &request, QNetworkReply *reply)
+{
+    request->winner = reply;
+    addLatency(request->timer.elapsed() - request->attempts[reply]);
+
+    // abort синхронно вызывает finished, поэтому attempts перебираем по копии
+    std::vector<QNetworkReply*> others;
+    for (const auto &pair: request->attempts) {
+        if (pair.first != reply) {
+            others.emplace_back(pair.first);
+        }
+    }
+    for (QNetworkReply *other: others) {
+        other->abort();
+    }
+}
+
+void MHUrlSchemeHandler::onAttemptHeaders(const std::shared_ptr<Request> &request, QNetworkReply *reply)
 {
 BEGIN_SLOT_WRAPPER
-    QNetworkReply *reply = qobject_cast<QNetworkReply *>(sender());
-    if (!reply) {
+    if (request->winner != nullptr || request->isFinished || !isNodeAnswered(*reply)) {
         return;
     }
-    QWebEngineUrlRequestJob *job = qobject_cast<QWebEngineUrlRequestJob *>(reply->parent());
+    chooseWinner(request, reply);
+    startStreaming(request, reply);
+END_SLOT_WRAPPER
+}
+
+// Ответ, который не попадет в кэш, отдаем сразу по заголовкам: тело читается из reply по мере получения.
+// Ответ без Content-Length (chunked) тоже не кэшируется: его размер заранее не ограничен MAX_ENTRY_SIZE,
+// и буферизовать его до конца нельзя. 304 и ошибки разбираются уже по finished
+void MHUrlSchemeHandler::startStreaming(const std::shared_ptr<Request> &request, QNetworkReply *reply)
+{
+    QWebEngineUrlRequestJob *job = request->job.data();
+    if (!job) {
+        return;
+    }
+    const int status = getStatus(*reply);
+    if (status < 200 || status >= 300) {
+        return;
+    }
+    const bool hasLength = reply->header(QNetworkRequest::ContentLengthHeader).isValid();
+    HttpCache::Entry entry;
+    if (!request->cacheKey.isEmpty() && hasLength && HttpCache::parseResponse(*reply, entry)) {
+        return;
+    }
+
+    request->isFinished = true;
+    statistic.misses++;
+    statistic.streamed++;
+    job->reply(getMime(*reply), reply);
+}
+
+void MHUrlSchemeHandler::onAttemptFinished(const std::shared_ptr<Request> &request, QNetworkReply *reply)
+{
+BEGIN_SLOT_WRAPPER
+    if (request->winner == nullptr && !request->isFinished && isNodeAnswered(*reply)) {
+        chooseWinner(request, reply);
+    }
+    request->attempts.erase(reply);
+    if (request->isFinished) {
+        // Победивший reply уже отдан job'у и принадлежит ему
+        if (reply != request->winner) {
+            reply->deleteLater();
+        }
+        return;
+    }
+    if (request->winner == reply) {
+        request->isFinished = true;
+        onRequestFinished(request, reply);
+        return;
+    }
+
+    reply->deleteLater();
+    if (request->winner != nullptr || !request->attempts.empty()) {
+        return;
+    }
+    if (sendAttempt(request)) {
+        statistic.retries++;
+        return;
+    }
+    request->isFinished = true;
+    if (!request->job.isNull()) {
+        request->job->fail(QWebEngineUrlRequestJob::UrlNotFound);
+    }
+END_SLOT_WRAPPER
+}
+
+void MHUrlSchemeHandler::onRequestFinished(const std::shared_ptr<Request> &request, QNetworkReply *reply)
+{
+    QWebEngineUrlRequestJob *job = request->job.data();
     if (!job) {
         return;
     }
@@ -58,13 +283,44 @@ BEGIN_SLOT_WRAPPER
         return;
     }
 
-    QVariant contentMimeType = reply->header(QNetworkRequest::ContentTypeHeader);
-    QByteArray mime = contentMimeType.toByteArray();
-    const int pos = mime.indexOf(';');
-    if (pos != -1) {
-        mime = mime.left(pos);
+    const int status = getStatus(*reply);
+    if (status == 304 && request->isCached) {
+        HttpCache::Entry entry = request->cached;
+        entry.expires = HttpCache::parseExpires(*reply);
+        cache->insert(request->cacheKey, entry);
+        statistic.revalidated++;
+        replyFromCache(job, entry);
+        return;
     }
 
-    job->reply(mime, reply);
-END_SLOT_WRAPPER
+    statistic.misses++;
+    const QByteArray mime = getMime(*reply);
+    HttpCache::Entry entry;
+    if (!request->cacheKey.isEmpty() && HttpCache::parseResponse(*reply, entry)) {
+        entry.mime = mime;
+        entry.body = reply->readAll();
+        cache->insert(request->cacheKey, entry);
+        replyFromCache(job, entry);
+    } else {
+        job->reply(mime, reply);
+    }
+}
+
+void MHUrlSchemeHandler::addLatency(qint64 latency)
+{
+    latencies.emplace_back(latency);
+    if (latencies.size() > MAX_LATENCIES) {
+        latencies.pop_front();
+    }
+}
+
+qint64 MHUrlSchemeHandler::getHedgeDelay() const
+{
+    if (latencies.size() < MIN_LATENCIES_FOR_HEDGE) {
+        return DEFAULT_HEDGE_DELAY_MS;
+    }
+    std::vector<qint64> sorted(latencies.begin(), latencies.end());
+    const size_t index = sorted.size() * 95 / 100;
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return std::min(std::max(sorted[index], MIN_HEDGE_DELAY_MS), MAX_HEDGE_DELAY_MS);
 }
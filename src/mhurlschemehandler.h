@@ -1,13 +1,34 @@
 #ifndef MHURLSCHEMEHANDLER_H
 #define MHURLSCHEMEHANDLER_H
 
+#include <memory>
+#include <deque>
+
 #include <QWebEngineUrlSchemeHandler>
 
+#include "HttpCache.h"
+
 class QNetworkAccessManager;
+class QNetworkReply;
 class QWebEngineUrlRequestJob;
 
 class MHUrlSchemeHandler : public QWebEngineUrlSchemeHandler
 {
+public:
+
+    struct Statistic {
+        size_t hits = 0;
+        size_t revalidated = 0;
+        size_t misses = 0;
+        size_t retries = 0;
+        size_t hedged = 0;
+        size_t streamed = 0;
+    };
+
+private:
+
+    struct Request;
+
 public:
     explicit MHUrlSchemeHandler(QObject *parent = nullptr);
 
@@ -15,12 +36,38 @@ public:
 
     void setLog();
 
-private slots:
-    void onRequestFinished();
+    // Если первый ip долго не отвечает, параллельно отправляется запрос на следующий
+    void setHedging(bool isHedging);
+
+private:
+    bool sendAttempt(const std::shared_ptr<Request> &request);
+
+    void chooseWinner(const std::shared_ptr<Request> &request, QNetworkReply *reply);
+
+    void onAttemptHeaders(const std::shared_ptr<Request> &request, QNetworkReply *reply);
+
+    void startStreaming(const std::shared_ptr<Request> &request, QNetworkReply *reply);
+
+    void onAttemptFinished(const std::shared_ptr<Request> &request, QNetworkReply *reply);
+
+    void onRequestFinished(const std::shared_ptr<Request> &request, QNetworkReply *reply);
+
+    void addLatency(qint64 latency);
+
+    qint64 getHedgeDelay() const;
 
 private:
     QNetworkAccessManager *m_manager;
 
+    std::unique_ptr<HttpCache> cache;
+
+    Statistic statistic;
+
+    // Время до получения заголовков у последних успешных запросов, мс
+    std::deque<qint64> latencies;
+
+    bool isHedging = true;
+
     bool isLog = false;
 };
 
@@ -6,6 +6,8 @@
 #include <memory>
 #include <functional>
 #include <array>
+#include <mutex>
+#include <thread>
 
 #include <openssl/rsa.h>
 #include <openssl/pem.h>
@@ -13,6 +15,11 @@
 #include <openssl/aes.h>
 #include <openssl/evp.h>
 #include <openssl/rand.h>
+#include <openssl/ec.h>
+#include <openssl/obj_mac.h>
+#include <openssl/hmac.h>
+#include <openssl/sha.h>
+#include <openssl/crypto.h>
 
 #include <QString>
 #include <QByteArray>
@@ -22,8 +29,31 @@
 
 static bool isInitialized = false;
 
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+// OpenSSL 1.0.x потокобезопасен только с установленными callback-ами блокировок.
+// Ставим свои, не надеясь на QtNetwork: у него может быть своя копия libcrypto
+static std::unique_ptr<std::mutex[]> opensslMutexes;
+
+static void opensslLockingCallback(int mode, int n, const char */*file*/, int /*line*/) {
+    if (mode & CRYPTO_LOCK) {
+        opensslMutexes[n].lock();
+    } else {
+        opensslMutexes[n].unlock();
+    }
+}
+
+static void opensslThreadIdCallback(CRYPTO_THREADID *id) {
+    CRYPTO_THREADID_set_numeric(id, (unsigned long)std::hash<std::thread::id>()(std::this_thread::get_id()));
+}
+#endif
+
 void InitOpenSSL() {
     CHECK(!isInitialized, "Already initialized");
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+    opensslMutexes.reset(new std::mutex[CRYPTO_num_locks()]);
+    CRYPTO_THREADID_set_callback(opensslThreadIdCallback);
+    CRYPTO_set_locking_callback(opensslLockingCallback);
+#endif
     /*SSL_load_error_strings();
     SSL_library_init();*/
     OpenSSL_add_all_algorithms();
@@ -259,3 +289,230 @@ std::string decrypt(const std::string &privkey, const std::string &password, con
 
     return result;
 }
+
+using BignumPtr = std::unique_ptr<BIGNUM, std::function<void(BIGNUM*)>>;
+
+static const EC_GROUP* getSecp256r1() {
+    // Таблицы для умножения генератора строятся один раз, дальше группа только читается из всех потоков
+    static const std::unique_ptr<EC_GROUP, std::function<void(EC_GROUP*)>> group = []() {
+        std::unique_ptr<EC_GROUP, std::function<void(EC_GROUP*)>> result(EC_GROUP_new_by_curve_name(NID_X9_62_prime256v1), EC_GROUP_free);
+        CHECK(result != nullptr, "Incorrect EC_GROUP_new_by_curve_name");
+        const bool res = EC_GROUP_precompute_mult(result.get(), nullptr);
+        CHECK(res, "Incorrect EC_GROUP_precompute_mult");
+        return result;
+    }();
+    return group.get();
+}
+
+static void getSecp256r1Order(BIGNUM *order, BN_CTX *ctx) {
+    CHECK(EC_GROUP_get_order(getSecp256r1(), order, ctx), "Incorrect EC_GROUP_get_order");
+}
+
+static BignumPtr newBignum(bool isSecret) {
+    BignumPtr result(BN_new(), isSecret ? BN_clear_free : BN_free);
+    CHECK(result != nullptr, "Incorrect BN_new");
+    if (isSecret) {
+        BN_set_flags(result.get(), BN_FLG_CONSTTIME);
+    }
+    return result;
+}
+
+static void bignumToBin(const BIGNUM *num, unsigned char *out, size_t size) {
+    const size_t numSize = BN_num_bytes(num);
+    CHECK(numSize <= size, "Incorrect bignum size");
+    std::fill(out, out + size - numSize, 0);
+    BN_bn2bin(num, out + size - numSize);
+}
+
+// e = SHA-256(message) mod q
+static void hashSecp256r1(const std::string &message, const BIGNUM *order, BN_CTX *ctx, BIGNUM *e) {
+    std::array<unsigned char, SHA256_DIGEST_LENGTH> hash;
+    SHA256((const unsigned char*)message.data(), message.size(), hash.data());
+    CHECK(BN_bin2bn(hash.data(), hash.size(), e) != nullptr, "Incorrect BN_bin2bn");
+    CHECK(BN_nnmod(e, e, order, ctx), "Incorrect BN_nnmod");
+}
+
+namespace {
+
+// Генератор k из RFC 6979 (раздел 3.2) для HMAC-SHA256 и порядка длиной 256 бит
+class Rfc6979Nonce {
+public:
+
+    Rfc6979Nonce(const std::array<unsigned char, 32> &privateKey, const std::array<unsigned char, 32> &hash) {
+        K.fill(0x00);
+        V.fill(0x01);
+        std::array<unsigned char, 32 + 1 + 32 + 32> data;
+        std::copy(privateKey.begin(), privateKey.end(), data.begin() + V.size() + 1);
+        std::copy(hash.begin(), hash.end(), data.begin() + V.size() + 1 + privateKey.size());
+        for (unsigned char i = 0; i < 2; i++) {
+            std::copy(V.begin(), V.end(), data.begin());
+            data[V.size()] = i;
+            hmac(data.data(), data.size(), K);
+            hmac(V.data(), V.size(), V);
+        }
+        OPENSSL_cleanse(data.data(), data.size());
+    }
+
+    ~Rfc6979Nonce() {
+        OPENSSL_cleanse(K.data(), K.size());
+        OPENSSL_cleanse(V.data(), V.size());
+    }
+
+    void next(const BIGNUM *order, BIGNUM *k) {
+        while (true) {
+            if (!isFirst) {
+                std::array<unsigned char, 32 + 1> data;
+                std::copy(V.begin(), V.end(), data.begin());
+                data[V.size()] = 0x00;
+                hmac(data.data(), data.size(), K);
+                hmac(V.data(), V.size(), V);
+            }
+            isFirst = false;
+
+            hmac(V.data(), V.size(), V);
+            CHECK(BN_bin2bn(V.data(), V.size(), k) != nullptr, "Incorrect BN_bin2bn");
+            if (!BN_is_zero(k) && BN_cmp(k, order) < 0) {
+                return;
+            }
+        }
+    }
+
+private:
+
+    void hmac(const unsigned char *data, size_t size, std::array<unsigned char, 32> &out) {
+        unsigned int outSize = out.size();
+        const bool res = HMAC(EVP_sha256(), K.data(), K.size(), data, size, out.data(), &outSize) != nullptr;
+        CHECK(res && outSize == out.size(), "Incorrect HMAC");
+    }
+
+private:
+
+    std::array<unsigned char, 32> K;
+    std::array<unsigned char, 32> V;
+
+    bool isFirst = true;
+};
+
+}
+
+std::string signSecp256r1(const std::array<unsigned char, 32> &privateKey, const std::string &message) {
+    const EC_GROUP *group = getSecp256r1();
+    const std::unique_ptr<BN_CTX, std::function<void(BN_CTX*)>> ctx(BN_CTX_new(), BN_CTX_free);
+    CHECK(ctx != nullptr, "Incorrect BN_CTX_new");
+
+    const BignumPtr orderPtr = newBignum(false);
+    getSecp256r1Order(orderPtr.get(), ctx.get());
+    const BIGNUM *order = orderPtr.get();
+
+    const BignumPtr x = newBignum(true);
+    CHECK(BN_bin2bn(privateKey.data(), privateKey.size(), x.get()) != nullptr, "Incorrect BN_bin2bn");
+    CHECK(!BN_is_zero(x.get()) && BN_cmp(x.get(), order) < 0, "Incorrect private key");
+
+    const BignumPtr e = newBignum(false);
+    hashSecp256r1(message, order, ctx.get(), e.get());
+    // Длина хэша равна длине порядка, так что bits2octets(h) = e
+    std::array<unsigned char, 32> hashReduced;
+    bignumToBin(e.get(), hashReduced.data(), hashReduced.size());
+
+    Rfc6979Nonce nonce(privateKey, hashReduced);
+
+    const std::unique_ptr<EC_POINT, std::function<void(EC_POINT*)>> point(EC_POINT_new(group), EC_POINT_clear_free);
+    CHECK(point != nullptr, "Incorrect EC_POINT_new");
+    const BignumPtr k = newBignum(true);
+    const BignumPtr kInv = newBignum(true);
+    const BignumPtr r = newBignum(false);
+    const BignumPtr s = newBignum(true);
+    while (true) {
+        nonce.next(order, k.get());
+
+        CHECK(EC_POINT_mul(group, point.get(), k.get(), nullptr, nullptr, ctx.get()), "Incorrect EC_POINT_mul");
+        CHECK(EC_POINT_get_affine_coordinates_GFp(group, point.get(), r.get(), nullptr, ctx.get()), "Incorrect EC_POINT_get_affine_coordinates_GFp");
+        CHECK(BN_nnmod(r.get(), r.get(), order, ctx.get()), "Incorrect BN_nnmod");
+        if (BN_is_zero(r.get())) {
+            continue;
+        }
+
+        // s = k^-1 * (e + x * r) mod q
+        CHECK(BN_mod_inverse(kInv.get(), k.get(), order, ctx.get()) != nullptr, "Incorrect BN_mod_inverse");
+        CHECK(BN_mod_mul(s.get(), x.get(), r.get(), order, ctx.get()), "Incorrect BN_mod_mul");
+        CHECK(BN_mod_add(s.get(), s.get(), e.get(), order, ctx.get()), "Incorrect BN_mod_add");
+        CHECK(BN_mod_mul(s.get(), s.get(), kInv.get(), order, ctx.get()), "Incorrect BN_mod_mul");
+        if (!BN_is_zero(s.get())) {
+            break;
+        }
+    }
+
+    std::string result(64, 0);
+    bignumToBin(r.get(), (unsigned char*)&result[0], 32);
+    bignumToBin(s.get(), (unsigned char*)&result[32], 32);
+    return result;
+}
+
+struct Secp256r1PublicKey {
+    std::unique_ptr<EC_POINT, std::function<void(EC_POINT*)>> point;
+};
+
+Secp256r1PublicKeyPtr parseSecp256r1PublicKey(const std::string &publicKeyDer) {
+    const EC_GROUP *group = getSecp256r1();
+    const std::unique_ptr<BN_CTX, std::function<void(BN_CTX*)>> ctx(BN_CTX_new(), BN_CTX_free);
+    CHECK(ctx != nullptr, "Incorrect BN_CTX_new");
+
+    const unsigned char *data = (const unsigned char*)publicKeyDer.data();
+    const std::unique_ptr<EC_KEY, std::function<void(EC_KEY*)>> key(d2i_EC_PUBKEY(nullptr, &data, publicKeyDer.size()), EC_KEY_free);
+    CHECK(key != nullptr, "Incorrect d2i_EC_PUBKEY");
+    CHECK(data == (const unsigned char*)publicKeyDer.data() + publicKeyDer.size(), "Incorrect public key size");
+    CHECK(EC_GROUP_cmp(EC_KEY_get0_group(key.get()), group, ctx.get()) == 0, "Public key not secp256r1");
+    const EC_POINT *point = EC_KEY_get0_public_key(key.get());
+    CHECK(point != nullptr && !EC_POINT_is_at_infinity(group, point), "Incorrect public key");
+    CHECK(EC_POINT_is_on_curve(group, point, ctx.get()) == 1, "Public key not on curve");
+
+    // Точка переносится на общую группу, чтобы умножение на генератор шло по предвычисленным таблицам
+    const auto result = std::make_shared<Secp256r1PublicKey>();
+    result->point = std::unique_ptr<EC_POINT, std::function<void(EC_POINT*)>>(EC_POINT_dup(point, group), EC_POINT_free);
+    CHECK(result->point != nullptr, "Incorrect EC_POINT_dup");
+    return result;
+}
+
+bool verifySecp256r1(const Secp256r1PublicKey &publicKey, const std::string &message, const std::string &signature) {
+    if (signature.size() != 64) {
+        return false;
+    }
+
+    const EC_GROUP *group = getSecp256r1();
+    const std::unique_ptr<BN_CTX, std::function<void(BN_CTX*)>> ctx(BN_CTX_new(), BN_CTX_free);
+    CHECK(ctx != nullptr, "Incorrect BN_CTX_new");
+
+    const BignumPtr order = newBignum(false);
+    getSecp256r1Order(order.get(), ctx.get());
+
+    const BignumPtr r = newBignum(false);
+    const BignumPtr s = newBignum(false);
+    CHECK(BN_bin2bn((const unsigned char*)signature.data(), 32, r.get()) != nullptr, "Incorrect BN_bin2bn");
+    CHECK(BN_bin2bn((const unsigned char*)signature.data() + 32, 32, s.get()) != nullptr, "Incorrect BN_bin2bn");
+    if (BN_is_zero(r.get()) || BN_cmp(r.get(), order.get()) >= 0 || BN_is_zero(s.get()) || BN_cmp(s.get(), order.get()) >= 0) {
+        return false;
+    }
+
+    const BignumPtr e = newBignum(false);
+    hashSecp256r1(message, order.get(), ctx.get(), e.get());
+
+    // R = (e / s) * G + (r / s) * Q, подпись верна если R.x mod q == r
+    const BignumPtr w = newBignum(false);
+    const BignumPtr u1 = newBignum(false);
+    const BignumPtr u2 = newBignum(false);
+    CHECK(BN_mod_inverse(w.get(), s.get(), order.get(), ctx.get()) != nullptr, "Incorrect BN_mod_inverse");
+    CHECK(BN_mod_mul(u1.get(), e.get(), w.get(), order.get(), ctx.get()), "Incorrect BN_mod_mul");
+    CHECK(BN_mod_mul(u2.get(), r.get(), w.get(), order.get(), ctx.get()), "Incorrect BN_mod_mul");
+
+    const std::unique_ptr<EC_POINT, std::function<void(EC_POINT*)>> point(EC_POINT_new(group), EC_POINT_free);
+    CHECK(point != nullptr, "Incorrect EC_POINT_new");
+    CHECK(EC_POINT_mul(group, point.get(), u1.get(), publicKey.point.get(), u2.get(), ctx.get()), "Incorrect EC_POINT_mul");
+    if (EC_POINT_is_at_infinity(group, point.get())) {
+        return false;
+    }
+
+    const BignumPtr x = newBignum(false);
+    CHECK(EC_POINT_get_affine_coordinates_GFp(group, point.get(), x.get(), nullptr, ctx.get()), "Incorrect EC_POINT_get_affine_coordinates_GFp");
+    CHECK(BN_nnmod(x.get(), x.get(), order.get(), ctx.get()), "Incorrect BN_nnmod");
+    return BN_cmp(x.get(), r.get()) == 0;
+}
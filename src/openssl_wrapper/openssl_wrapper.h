@@ -2,6 +2,8 @@
 #define OPENSSL_WRAPPER_H
 
 #include <string>
+#include <array>
+#include <memory>
 
 void InitOpenSSL();
 
@@ -16,4 +18,20 @@ std::string encrypt(const std::string &pubkey, const std::string &message);
 
 std::string decrypt(const std::string &privkey, const std::string &password, const std::string &message);
 
+/*
+   ECDSA secp256r1 + SHA-256 с детерминированным k (RFC 6979).
+   privateKey - экспонента в big-endian, результат - r || s по 32 байта
+*/
+std::string signSecp256r1(const std::array<unsigned char, 32> &privateKey, const std::string &message);
+
+struct Secp256r1PublicKey;
+
+using Secp256r1PublicKeyPtr = std::shared_ptr<const Secp256r1PublicKey>;
+
+// publicKeyDer - SubjectPublicKeyInfo в DER. Разобранный ключ можно использовать из нескольких потоков
+Secp256r1PublicKeyPtr parseSecp256r1PublicKey(const std::string &publicKeyDer);
+
+// signature - r || s по 32 байта
+bool verifySecp256r1(const Secp256r1PublicKey &publicKey, const std::string &message, const std::string &signature);
+
 #endif // OPENSSL_WRAPPER_H
@@ -23,4 +23,19 @@ const bool isProductionSetup = false;
 #error Define PRODUCTION or DEVELOPMENT macros!
 #endif
 
+// Страницы интерфейса отдаются из упаковки по HTMLS_URL вместо file://.
+// Выключено по умолчанию: у страниц меняется origin, а с ним и localStorage
+#if defined(HTMLS_SCHEME)
+const bool isHtmlsSchemeSetup = true;
+#else
+const bool isHtmlsSchemeSetup = false;
+#endif
+
+// Если первый ip mh:// долго не отвечает, параллельно запрашивается следующий
+#if defined(MH_NO_HEDGING)
+const bool isMhHedgingSetup = false;
+#else
+const bool isMhHedgingSetup = true;
+#endif
+
 #endif // PLATFORM_H
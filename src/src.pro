@@ -5,6 +5,9 @@ TARGET = MetaGate
 DEFINES += VERSION_STRING=\\\"1.15.0\\\"
 #DEFINES += DEVELOPMENT
 DEFINES += PRODUCTION
+#DEFINES += HTMLS_SCHEME
+#DEFINES += MH_NO_HEDGING
+#DEFINES += LOG_DEBUG_ENABLED
 DEFINES += APPLICATION_NAME=\\\"MetaGate\\\"
 
 DEFINES += GIT_CURRENT_SHA1="\\\"$$system(git rev-parse --short HEAD)\\\""
@@ -15,8 +18,12 @@ SOURCES += main.cpp mainwindow.cpp \
     machine_uid_win.cpp \
     unzip.cpp \
     uploader.cpp \
+    HtmlManifest.cpp \
+    HtmlStore.cpp \
     EthWallet.cpp \
     ethtx/scrypt/crypto_scrypt-nosse.cpp \
+    ethtx/scrypt/crypto_scrypt-sse.cpp \
+    ethtx/scrypt/crypto_scrypt_smix.cpp \
     ethtx/scrypt/sha256.cpp \
     ethtx/cert.cpp \
     ethtx/rlp.cpp \
@@ -36,6 +43,7 @@ SOURCES += main.cpp mainwindow.cpp \
     utils.cpp \
     ethtx/utils2.cpp \
     NsLookup.cpp \
+    DnsResolver.cpp \
     dns/datatransformer.cpp \
     dns/dnspacket.cpp \
     dns/resourcerecord.cpp \
@@ -43,9 +51,19 @@ SOURCES += main.cpp mainwindow.cpp \
     JavascriptWrapper.cpp \
     PagesMappings.cpp \
     mhurlschemehandler.cpp \
+    HttpCache.cpp \
+    htmlsschemehandler.cpp \
+    HtmlPack.cpp \
     Paths.cpp \
     RunGuard.cpp \
-    qrcoder.cpp
+    qrcoder.cpp \
+    ThreadPool.cpp \
+    SecureMemory.cpp \
+    KeySessions.cpp \
+    JobExecutor.cpp \
+    LogRotation.cpp \
+    WalletsInventory.cpp \
+    Codecs.cpp
 
 unix: SOURCES += machine_uid_unix.cpp
 
@@ -57,10 +75,13 @@ HEADERS += mainwindow.h \
     WindowEvents.h \
     unzip.h \
     uploader.h \
+    HtmlManifest.h \
+    HtmlStore.h \
     EthWallet.h \
     ethtx/scrypt/libscrypt.h \
     ethtx/scrypt/sha256.h \
     ethtx/scrypt/sysendian.h \
+    ethtx/scrypt/crypto_scrypt_smix.h \
     ethtx/cert.h \
     ethtx/const.h \
     ethtx/rlp.h \
@@ -83,6 +104,7 @@ HEADERS += mainwindow.h \
     utils.h \
     ethtx/utils2.h \
     NsLookup.h \
+    DnsResolver.h \
     dns/datatransformer.h \
     dns/dnspacket.h \
     dns/resourcerecord.h \
@@ -92,10 +114,20 @@ HEADERS += mainwindow.h \
     PagesMappings.h \
     SlotWrapper.h \
     mhurlschemehandler.h \
+    HttpCache.h \
+    htmlsschemehandler.h \
+    HtmlPack.h \
     Paths.h \
     RunGuard.h \
     makeJsFunc.h \
-    qrcoder.h
+    qrcoder.h \
+    ThreadPool.h \
+    SecureMemory.h \
+    KeySessions.h \
+    JobExecutor.h \
+    LogRotation.h \
+    WalletsInventory.h \
+    Codecs.h
 
 FORMS += mainwindow.ui
 
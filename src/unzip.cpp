@@ -1,18 +1,136 @@
 #include "unzip.h"
 
 #include <iostream>
+#include <atomic>
+#include <vector>
+#include <algorithm>
 
 #include <QDateTime>
 #include <QStandardPaths>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
 
 #include "check.h"
 #include "utils.h"
+#include "ThreadPool.h"
 
 #include <quazip/JlCompress.h>
+#include <quazip/quazip.h>
+#include <quazip/quazipfile.h>
 
-void extractDir(QString fileCompressed, QString dir) {
-    const QStringList lst = JlCompress::extractDir(fileCompressed, dir);
-    CHECK(!lst.empty(), "Error extracted archive " + fileCompressed.toStdString());
+static void extractEntry(QuaZip &zip, const QuaZipFileInfo64 &info, const QString &path) {
+    QuaZipFile inFile(&zip);
+    CHECK(inFile.open(QIODevice::ReadOnly) && inFile.getZipError() == UNZ_OK, "Error read archive file " + info.name.toStdString());
+
+    QFile outFile(path);
+    CHECK(outFile.open(QIODevice::WriteOnly), "Not open file " + path.toStdString());
+
+    std::vector<char> buffer(64 * 1024);
+    while (true) {
+        const qint64 readLen = inFile.read(buffer.data(), buffer.size());
+        CHECK(readLen >= 0, "Error read archive file " + info.name.toStdString());
+        if (readLen == 0) {
+            break;
+        }
+        CHECK(outFile.write(buffer.data(), readLen) == readLen, "Error write file " + path.toStdString());
+    }
+    CHECK(quint64(outFile.pos()) == info.uncompressedSize, "Incorrect size of archive file " + info.name.toStdString());
+
+    inFile.close();
+    CHECK(inFile.getZipError() == UNZ_OK, "Error read archive file " + info.name.toStdString());
+    outFile.close();
+
+    const QFile::Permissions permissions = info.getPermissions();
+    if (permissions != 0) {
+        outFile.setPermissions(permissions);
+    }
+}
+
+void extractDir(QString fileCompressed, QString dir, size_t maxThreads, const ExtractProgressCallback &progress) {
+    QuaZip zip(fileCompressed);
+    CHECK(zip.open(QuaZip::mdUnzip), "Error open archive " + fileCompressed.toStdString());
+    const QList<QuaZipFileInfo64> infos = zip.getFileInfoList64();
+    zip.close();
+    CHECK(zip.getZipError() == UNZ_OK && !infos.empty(), "Error extracted archive " + fileCompressed.toStdString());
+
+    // Архив распаковывается в соседнюю временную папку и переносится на место только целиком,
+    // поэтому битый архив не трогает уже лежащие в dir файлы (restoreKeys распаковывает прямо в папку ключей)
+    const QDir directory(dir);
+    const QString rootPath = QDir::cleanPath(directory.absolutePath()) + "/";
+    QDir staging(QDir::cleanPath(directory.absolutePath()) + ".extracting");
+    staging.removeRecursively();
+    const QString stagingRootPath = QDir::cleanPath(staging.absolutePath()) + "/";
+
+    // Папки создаются заранее в одном потоке, рабочие потоки только пишут файлы
+    std::vector<QString> paths;
+    std::vector<QString> stagingPaths;
+    paths.reserve(infos.size());
+    stagingPaths.reserve(infos.size());
+    for (const QuaZipFileInfo64 &info: infos) {
+        const QString path = QDir::cleanPath(directory.absoluteFilePath(info.name));
+        CHECK(path.startsWith(rootPath), "Incorrect path in archive " + info.name.toStdString());
+        const QString stagingPath = stagingRootPath + path.mid(rootPath.size());
+        if (info.name.endsWith('/')) {
+            createFolder(stagingPath);
+        } else {
+            createFolder(QFileInfo(stagingPath).absolutePath());
+        }
+        paths.emplace_back(path);
+        stagingPaths.emplace_back(stagingPath);
+    }
+
+    const size_t total = paths.size();
+    std::atomic<size_t> next(0);
+    std::atomic<size_t> extracted(0);
+    const size_t workers = std::min(total, ThreadPool::shared().getMaxThreads());
+    try {
+        ThreadPool::shared().parallelFor(workers, [&](size_t) {
+            QuaZip workerZip(fileCompressed);
+            CHECK(workerZip.open(QuaZip::mdUnzip) && workerZip.goToFirstFile(), "Error open archive " + fileCompressed.toStdString());
+            // Номера файлов, которые берет поток, только растут, поэтому каждый поток проходит центральный каталог один раз
+            size_t current = 0;
+            size_t i;
+            while ((i = next.fetch_add(1)) < total) {
+                try {
+                    for (; current < i; current++) {
+                        CHECK(workerZip.goToNextFile(), "Error read archive " + fileCompressed.toStdString());
+                    }
+                    const QuaZipFileInfo64 &info = infos.at(int(i));
+                    if (!info.name.endsWith('/')) {
+                        extractEntry(workerZip, info, stagingPaths[i]);
+                    }
+                } catch (...) {
+                    next.store(total);
+                    throw;
+                }
+                const size_t done = extracted.fetch_add(1) + 1;
+                if (progress) {
+                    progress(done, total);
+                }
+            }
+            workerZip.close();
+        }, maxThreads);
+    } catch (...) {
+        staging.removeRecursively();
+        throw;
+    }
+
+    try {
+        for (size_t i = 0; i < total; i++) {
+            if (infos.at(int(i)).name.endsWith('/')) {
+                createFolder(paths[i]);
+            } else {
+                createFolder(QFileInfo(paths[i]).absolutePath());
+                removeFile(paths[i]);
+                CHECK(QFile::rename(stagingPaths[i], paths[i]), "Not rename file " + stagingPaths[i].toStdString());
+            }
+        }
+    } catch (...) {
+        staging.removeRecursively();
+        throw;
+    }
+    staging.removeRecursively();
 }
 
 void compressDir(QString dir, QString fileCompressed) {
@@ -4,8 +4,13 @@
 #include <QString>
 
 #include <string>
+#include <functional>
 
-void extractDir(QString fileCompressed, QString dir);
+using ExtractProgressCallback = std::function<void(size_t extracted, size_t total)>;
+
+// Файлы распаковываются параллельно на ThreadPool::shared(), у каждого потока свой QuaZip.
+// При ошибке в dir ничего не меняется. progress вызывается из рабочих потоков
+void extractDir(QString fileCompressed, QString dir, size_t maxThreads = 0, const ExtractProgressCallback &progress = ExtractProgressCallback());
 
 void compressDir(QString dir, QString fileCompressed);
 
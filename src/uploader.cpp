@@ -13,6 +13,7 @@
 #include <QJsonValue>
 #include <QJsonObject>
 #include <QCryptographicHash>
+#include <QFileInfo>
 
 #include "mainwindow.h"
 
@@ -25,9 +26,14 @@
 #include "utils.h"
 #include "SlotWrapper.h"
 #include "Paths.h"
+#include "HtmlPack.h"
 
 std::mutex Uploader::lastVersionMut;
 
+const static size_t MAX_DELTA_DOWNLOADS = 6;
+
+const static size_t MAX_STORED_VERSIONS = 5;
+
 static QString toHash(const QString &valueQ) {
     const std::string value = valueQ.toStdString();
     QByteArray array(value.data(), value.size());
@@ -129,6 +135,7 @@ Uploader::Uploader(MainWindow *mainWindow)
     CHECK(connect(&client, SIGNAL(callbackCall(ReturnCallback)), this, SLOT(callbackCall(ReturnCallback))), "not connect");
 
     currentBeginPath = getPagesPath();
+    store = std::make_unique<HtmlStore>(makePath(currentBeginPath, "store"));
     const auto &lastVersionPair = Uploader::getLastVersion(currentBeginPath);
     currFolder = lastVersionPair.first;
     lastVersion = lastVersionPair.second;
@@ -183,6 +190,230 @@ static void clearFolderHtmls(const QString &folderHtmls, const QString &currentV
     }
 }
 
+static void clearOldDownloads(const QString &folder, const QString &currentDownload) {
+    QDir sourceDir(folder);
+    for (const QFileInfo &file: sourceDir.entryInfoList(QStringList() << "*.zip.part", QDir::Files)) {
+        if (!isPathEquals(file.absoluteFilePath(), QFileInfo(currentDownload).absoluteFilePath())) {
+            removeFile(file.absoluteFilePath());
+        }
+    }
+}
+
+void Uploader::installHtmls(const QString &folderServer, const QString &version) {
+    Uploader::setLastVersion(currentBeginPath, folderServer, version);
+
+    lastVersion = version;
+    currFolder = folderServer;
+
+    emit generateEvent(WindowEvent::RELOAD_PAGE);
+}
+
+static QString stagingPath(const QString &pagesPath, const QString &folderServer, const QString &version) {
+    return makePath(pagesPath, folderServer, version + ".staging");
+}
+
+void Uploader::commitHtmls(const HtmlUpdate &update, const QString &stagingDir, const HtmlManifest &manifest) {
+    store->addVersion(stagingDir, manifest);
+    saveHtmlManifest(stagingDir, manifest);
+    if (isHtmlsSchemeSetup) {
+        HtmlPack::write(stagingDir, manifest);
+    }
+
+    // Переключение на новую версию атомарно: папка появляется целиком или не появляется вовсе
+    const QString versionDir = makePath(currentBeginPath, update.folderServer, update.version);
+    QDir(versionDir).removeRecursively();
+    CHECK(QDir().rename(stagingDir, versionDir), "Not rename " + stagingDir.toStdString());
+    LOG << "Installed html " << versionDir << ".";
+
+    store->saveManifest(update.folderServer + "_" + update.version, manifest);
+    store->collectGarbage(MAX_STORED_VERSIONS);
+
+    installHtmls(update.folderServer, update.version);
+}
+
+bool Uploader::restoreFromStore(const HtmlUpdate &update) {
+    HtmlManifest manifest;
+    if (!store->findManifest(update.folderServer + "_" + update.version, manifest) || !store->containsVersion(manifest)) {
+        return false;
+    }
+
+    clearFolderHtmls(makePath(currentBeginPath, update.folderServer), lastVersion);
+    const QString stagingDir = stagingPath(currentBeginPath, update.folderServer, update.version);
+    createFolder(stagingDir);
+    store->materializeVersion(manifest, stagingDir);
+    LOG << "Html version " << update.version << " restored from store";
+    commitHtmls(update, stagingDir, manifest);
+    return true;
+}
+
+void Uploader::downloadFull(const HtmlUpdate &update) {
+    // Недокачанный архив остается на диске и докачивается при следующей попытке
+    const QString archiveFilePath = makePath(currentBeginPath, update.version + ".zip.part");
+
+    auto interfaceGetCallback = [this, update, archiveFilePath](const std::string &result) {
+        versionHtmlForUpdate = "";
+        CHECK(result != SimpleClient::ERROR_BAD_REQUEST, "Bad request");
+
+        if (update.version == lastVersion && update.folderServer == currFolder) { // Так как это callback, то проверим еще раз
+            removeFile(archiveFilePath);
+            return;
+        }
+
+        const QString hashStr = QString::fromStdString(result);
+        if (hashStr != update.hash) {
+            removeFile(archiveFilePath);
+            throwErr(("hash zip not equal response hash: hash zip: " + hashStr + ", hash response: " + update.hash).toStdString());
+        }
+
+        clearFolderHtmls(makePath(currentBeginPath, update.folderServer), lastVersion);
+
+        const QString stagingDir = stagingPath(currentBeginPath, update.folderServer, update.version);
+        extractDir(archiveFilePath, stagingDir);
+        LOG << "Extracted " << stagingDir << ".";
+        removeFile(archiveFilePath);
+
+        commitHtmls(update, stagingDir, calcHtmlManifest(stagingDir));
+    };
+
+    clearOldDownloads(currentBeginPath, archiveFilePath);
+
+    LOG << "download html";
+    client.downloadFile(update.url, archiveFilePath, interfaceGetCallback);
+    versionHtmlForUpdate = update.version;
+}
+
+void Uploader::downloadDelta(const HtmlUpdate &update) {
+    const auto delta = std::make_shared<DeltaUpdate>();
+    delta->update = update;
+    delta->currentDir = makePath(currentBeginPath, currFolder, lastVersion);
+    delta->currentManifest = loadHtmlManifest(delta->currentDir);
+
+    QJsonObject params;
+    params.insert("version", lastVersion);
+    params.insert("target", update.version);
+    params.insert("files", htmlManifestToJson(delta->currentManifest));
+    QJsonObject request;
+    request.insert("id", QString::fromStdString(std::to_string(id)));
+    request.insert("version", "1.0.0");
+    request.insert("method", "interface.get.delta");
+    request.insert("token", "");
+    request.insert("params", QJsonArray{params});
+
+    auto callbackDelta = [this, delta](const std::string &result) {
+        try {
+            applyDelta(delta, result);
+        } catch (const Exception &e) {
+            LOG << "Delta update failed: " << e << ". Download full archive";
+            // Полный архив распаковывается в ту же staging папку, остатки дельты попали бы в манифест
+            if (!delta->stagingDir.isEmpty()) {
+                QDir(delta->stagingDir).removeRecursively();
+            }
+            downloadFull(delta->update);
+        }
+    };
+
+    LOG << "download html delta from " << lastVersion;
+    client.sendMessagePost(QUrl(serverName), QString(QJsonDocument(request).toJson(QJsonDocument::Compact)), callbackDelta);
+    versionHtmlForUpdate = update.version;
+    id++;
+}
+
+void Uploader::applyDelta(const std::shared_ptr<DeltaUpdate> &delta, const std::string &result) {
+    CHECK(result != SimpleClient::ERROR_BAD_REQUEST, "Bad request");
+    const QJsonDocument document = QJsonDocument::fromJson(QString::fromStdString(result).toUtf8());
+    const QJsonObject root = document.object();
+    CHECK(root.contains("data") && root.value("data").isObject(), "data field not found");
+    const auto &dataJson = root.value("data").toObject();
+    CHECK(dataJson.contains("version") && dataJson.value("version").isString(), "version field not found");
+    CHECK(dataJson.value("version").toString() == delta->update.version, "Incorrect delta version");
+    CHECK(dataJson.contains("files") && dataJson.value("files").isArray(), "files field not found");
+
+    // files - полный манифест новой версии. url есть только у изменившихся файлов
+    const QString stagingDir = stagingPath(currentBeginPath, delta->update.folderServer, delta->update.version);
+    clearFolderHtmls(makePath(currentBeginPath, delta->update.folderServer), lastVersion);
+    createFolder(stagingDir);
+    delta->stagingDir = stagingDir;
+
+    size_t reused = 0;
+    for (const QJsonValue &fileJson: dataJson.value("files").toArray()) {
+        CHECK(fileJson.isObject(), "Incorrect files field");
+        const QJsonObject fileObj = fileJson.toObject();
+        CHECK(fileObj.contains("path") && fileObj.value("path").isString(), "path field not found");
+        DeltaFile file;
+        file.path = fileObj.value("path").toString();
+        CHECK(isCorrectManifestPath(file.path), "Incorrect path " + file.path.toStdString());
+        CHECK(fileObj.contains("hash") && fileObj.value("hash").isString(), "hash field not found");
+        file.hash = fileObj.value("hash").toString().toLower();
+        CHECK(delta->manifest.find(file.path) == delta->manifest.end(), "Duplicate path " + file.path.toStdString());
+        delta->manifest[file.path] = file.hash;
+
+        const QString targetPath = makePath(stagingDir, file.path);
+        createFolder(QFileInfo(targetPath).absolutePath());
+        const auto found = delta->currentManifest.find(file.path);
+        if (store->contains(file.hash)) {
+            store->materialize(file.hash, targetPath);
+            reused++;
+        } else if (found != delta->currentManifest.end() && found->second == file.hash) {
+            CHECK(QFile::copy(makePath(delta->currentDir, file.path), targetPath), "Not copy file " + file.path.toStdString());
+            reused++;
+        } else {
+            CHECK(fileObj.contains("url") && fileObj.value("url").isString(), "url field not found for changed file " + file.path.toStdString());
+            file.url = fileObj.value("url").toString();
+            delta->files.emplace_back(file);
+        }
+    }
+
+    LOG << "Html delta: " << delta->files.size() << " changed files, " << reused << " unchanged";
+    continueDelta(delta);
+}
+
+void Uploader::continueDelta(const std::shared_ptr<DeltaUpdate> &delta) {
+    while (delta->inProcess < MAX_DELTA_DOWNLOADS && delta->next < delta->files.size() && !delta->isFailed) {
+        const DeltaFile &file = delta->files[delta->next];
+        delta->next++;
+        delta->inProcess++;
+
+        const QString targetPath = makePath(delta->stagingDir, file.path);
+        const QString expectedHash = file.hash;
+        try {
+            client.downloadFile(file.url, targetPath, [this, delta, targetPath, expectedHash](const std::string &result) {
+                delta->inProcess--;
+                if (result == SimpleClient::ERROR_BAD_REQUEST || QString::fromStdString(result) != expectedHash) {
+                    LOG << "Html delta file " << targetPath << " not loaded";
+                    delta->isFailed = true;
+                }
+                continueDelta(delta);
+            });
+        } catch (const Exception &e) {
+            LOG << "Html delta file " << targetPath << " not loaded: " << e;
+            delta->inProcess--;
+            delta->isFailed = true;
+        }
+    }
+
+    if (delta->inProcess == 0 && (delta->isFailed || delta->next == delta->files.size())) {
+        finishDelta(delta);
+    }
+}
+
+void Uploader::finishDelta(const std::shared_ptr<DeltaUpdate> &delta) {
+    const HtmlUpdate &update = delta->update;
+    if (delta->isFailed) {
+        QDir(delta->stagingDir).removeRecursively();
+        LOG << "Delta update failed. Download full archive";
+        downloadFull(update);
+        return;
+    }
+
+    versionHtmlForUpdate = "";
+    if (update.version == lastVersion && update.folderServer == currFolder) {
+        QDir(delta->stagingDir).removeRecursively();
+        return;
+    }
+
+    commitHtmls(update, delta->stagingDir, delta->manifest);
+}
+
 void Uploader::uploadEvent() {
 BEGIN_SLOT_WRAPPER
     const QString UPDATE_API = serverName;
@@ -214,41 +445,28 @@ BEGIN_SLOT_WRAPPER
             return;
         }
 
-        auto interfaceGetCallback = [this, version, hash, UPDATE_API, folderServer](const std::string &result) {
-            versionHtmlForUpdate = "";
-            CHECK(result != SimpleClient::ERROR_BAD_REQUEST, "Bad request");
+        HtmlUpdate update;
+        update.version = version;
+        update.hash = hash;
+        update.url = url;
+        update.folderServer = folderServer;
 
-            if (version == lastVersion && folderServer == currFolder) { // Так как это callback, то проверим еще раз
+        try {
+            if (restoreFromStore(update)) {
                 return;
             }
-
-            QCryptographicHash hashAlg(QCryptographicHash::Md5);
-            hashAlg.addData(result.data(), result.size());
-            const QString hashStr(hashAlg.result().toHex());
-            CHECK(hashStr == hash, ("hash zip not equal response hash: hash zip: " + hashStr + ", hash response: " + hash).toStdString());
-
-            clearFolderHtmls(makePath(currentBeginPath, folderServer), lastVersion);
-
-            const QString archiveFilePath = makePath(currentBeginPath, version + ".zip");
-            writeToFileBinary(archiveFilePath, result, false);
-
-            const QString extractedPath = makePath(currentBeginPath, folderServer, version);
-            extractDir(archiveFilePath, extractedPath);
-            LOG << "Extracted " << extractedPath << ".";
-            removeFile(archiveFilePath);
-
-            Uploader::setLastVersion(currentBeginPath, folderServer, version);
-
-            lastVersion = version;
-            currFolder = folderServer;
-
-            emit generateEvent(WindowEvent::RELOAD_PAGE);
-        };
-
-        LOG << "download html";
-        versionHtmlForUpdate = version;
-        client.sendMessageGet(url, interfaceGetCallback);
-        id++;
+        } catch (const Exception &e) {
+            LOG << "Restore html from store failed: " << e;
+        }
+        if (folderServer == currFolder && isExistFolder(makePath(currentBeginPath, currFolder, lastVersion))) {
+            try {
+                downloadDelta(update);
+                return;
+            } catch (const Exception &e) {
+                LOG << "Delta update failed: " << e << ". Download full archive";
+            }
+        }
+        downloadFull(update);
     };
 
     client.sendMessagePost(QUrl(UPDATE_API), QString::fromStdString("{\"id\": \"" + std::to_string(id) + "\",\"version\":\"1.0.0\",\"method\":\"interface.get.url\", \"token\":\"\", \"params\":[]}"), callbackGetHtmls);
@@ -3,6 +3,8 @@
 
 #include <mutex>
 #include <string>
+#include <memory>
+#include <vector>
 
 #include <QString>
 #include <QObject>
@@ -15,6 +17,9 @@
 
 #include "VersionWrapper.h"
 
+#include "HtmlManifest.h"
+#include "HtmlStore.h"
+
 class MainWindow;
 
 struct LastHtmlVersion {
@@ -35,6 +40,34 @@ private:
         std::string prod;
     };
 
+    struct HtmlUpdate {
+        QString version;
+        QString hash;
+        QString url;
+        QString folderServer;
+    };
+
+    struct DeltaFile {
+        QString path;
+        QString hash;
+        QString url;
+    };
+
+    struct DeltaUpdate {
+        HtmlUpdate update;
+
+        QString currentDir;
+        HtmlManifest currentManifest;
+
+        QString stagingDir;
+        HtmlManifest manifest;
+
+        std::vector<DeltaFile> files;
+        size_t next = 0;
+        size_t inProcess = 0;
+        bool isFailed = false;
+    };
+
 public:
 
     explicit Uploader(MainWindow *mainWindow);
@@ -73,6 +106,27 @@ signals:
 
     void generateUpdateApp(const QString version, const QString reference, const QString message);
 
+private:
+
+    void installHtmls(const QString &folderServer, const QString &version);
+
+    // Кладет файлы в хранилище, затем переименовывает stagingDir в папку версии
+    void commitHtmls(const HtmlUpdate &update, const QString &stagingDir, const HtmlManifest &manifest);
+
+    // Собирает версию из хранилища без сети, если там есть ее манифест и все файлы
+    bool restoreFromStore(const HtmlUpdate &update);
+
+    void downloadFull(const HtmlUpdate &update);
+
+    // Скачивает только изменившиеся файлы, при любой ошибке переходит на полный архив
+    void downloadDelta(const HtmlUpdate &update);
+
+    void applyDelta(const std::shared_ptr<DeltaUpdate> &delta, const std::string &result);
+
+    void continueDelta(const std::shared_ptr<DeltaUpdate> &delta);
+
+    void finishDelta(const std::shared_ptr<DeltaUpdate> &delta);
+
 private:
 
     MainWindow *mainWindow;
@@ -85,6 +139,8 @@ private:
 
     QString currentBeginPath;
 
+    std::unique_ptr<HtmlStore> store;
+
     QString currFolder;
 
     QString lastVersion;
@@ -11,21 +11,30 @@
 
 #include "btctx/Base58.h"
 
+#include "Codecs.h"
+
 #include "check.h"
 
 std::string toHex(const std::string &data) {
-    QByteArray array(data.data(), data.size());
-    return QString(array.toHex()).toStdString();
+    std::string result(hexEncodedSize(data.size()), 0);
+    encodeHex(data.data(), data.size(), &result[0]);
+    return result;
 }
 
 std::string toBase64(const std::string &value) {
-    QByteArray array(value.data(), value.size());
-    return QString(array.toBase64()).toStdString();
+    std::string result(base64EncodedSize(value.size()), 0);
+    encodeBase64(value.data(), value.size(), &result[0]);
+    return result;
 }
 
 std::string fromBase64(const std::string &value) {
-    QByteArray pubKeyArray(value.data(), value.size());
-    return QByteArray::fromBase64(pubKeyArray).toStdString();
+    std::string result(base64DecodedSize(value.data(), value.size()), 0);
+    if (decodeBase64(value.data(), value.size(), &result[0])) {
+        return result;
+    }
+    // Переносы строк, base64 без выравнивания и прочий мусор Qt пропускает, сохраняем это поведение
+    const QByteArray array(value.data(), value.size());
+    return QByteArray::fromBase64(array).toStdString();
 }
 
 std::string base58ToHex(const std::string &value) {
@@ -36,8 +45,13 @@ std::string base58ToHex(const std::string &value) {
 }
 
 std::string fromHex(const std::string &value) {
-    QByteArray pubKeyArray(value.data(), value.size());
-    return QByteArray::fromHex(pubKeyArray).toStdString();
+    std::string result(hexDecodedSize(value.size()), 0);
+    if (decodeHex(value.data(), value.size(), &result[0])) {
+        return result;
+    }
+    // Некорректные символы и нечетную длину Qt разбирает по-своему, сохраняем это поведение
+    const QByteArray array(value.data(), value.size());
+    return QByteArray::fromHex(array).toStdString();
 }
 
 bool isDecimal(const std::string &str) {
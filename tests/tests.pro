@@ -1,3 +1,3 @@
 TEMPLATE = subdirs
 CONFIG += ordered
-SUBDIRS += tst_wallet tst_qrcoder
+SUBDIRS += tst_wallet tst_qrcoder tst_scrypt
@@ -0,0 +1,153 @@
+#include "tst_scrypt.h"
+
+#include "ethtx/scrypt/libscrypt.h"
+
+static QByteArray scrypt(const QByteArray &password, const QByteArray &salt, quint64 N, quint32 r, quint32 p, size_t dkLen) {
+    QByteArray result(int(dkLen), '\0');
+    const int res = libscrypt_scrypt(
+        (const uint8_t*)password.data(), size_t(password.size()),
+        (const uint8_t*)salt.data(), size_t(salt.size()),
+        N, r, p,
+        (uint8_t*)result.data(), dkLen
+    );
+    if (res != 0) {
+        return QByteArray();
+    }
+    return result;
+}
+
+static void addKernelRows(const char *name, const QByteArray &password, const QByteArray &salt, quint64 N, quint32 r, quint32 p, const QByteArray &answer) {
+    for (int kernel: {LIBSCRYPT_KERNEL_NOSSE, LIBSCRYPT_KERNEL_SSE2, LIBSCRYPT_KERNEL_AVX2}) {
+        QTest::newRow((QByteArray(name) + " " + libscrypt_kernel_name(kernel)).constData())
+            << kernel << password << salt << N << r << p << answer;
+    }
+}
+
+tst_Scrypt::tst_Scrypt(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void tst_Scrypt::cleanup() {
+    libscrypt_set_kernel(LIBSCRYPT_KERNEL_AUTO);
+    libscrypt_set_max_threads(0);
+}
+
+void tst_Scrypt::testScryptVectors_data() {
+    QTest::addColumn<int>("kernel");
+    QTest::addColumn<QByteArray>("password");
+    QTest::addColumn<QByteArray>("salt");
+    QTest::addColumn<quint64>("N");
+    QTest::addColumn<quint32>("r");
+    QTest::addColumn<quint32>("p");
+    QTest::addColumn<QByteArray>("answer");
+
+    // RFC 7914, section 12
+    addKernelRows("rfc7914 1", "", "", 16, 1, 1,
+        QByteArray::fromHex("77d6576238657b203b19ca42c18a0497f16b4844e3074ae8dfdffa3fede21442fcd0069ded0948f8326a753a0fc81f17e8d3e0fb2e0d3628cf35e20c38d18906"));
+    addKernelRows("rfc7914 2", "password", "NaCl", 1024, 8, 16,
+        QByteArray::fromHex("fdbabe1c9d3472007856e7190d01e9fe7c6ad7cbc8237830e77376634b3731622eaf30d92e22a3886ff109279d9830dac727afb94a83ee6d8360cbdfa2cc0640"));
+    addKernelRows("rfc7914 3", "pleaseletmein", "SodiumChloride", 16384, 8, 1,
+        QByteArray::fromHex("7023bdcb3afd7348461c06cd81fd38ebfda8fbba904f8e3ea9b543f6545da1f2d5432955613f0fcf62d49705242a9af9e61e85dc0d651e40dfcf017b45575887"));
+}
+
+void tst_Scrypt::testScryptVectors() {
+    QFETCH(int, kernel);
+    QFETCH(QByteArray, password);
+    QFETCH(QByteArray, salt);
+    QFETCH(quint64, N);
+    QFETCH(quint32, r);
+    QFETCH(quint32, p);
+    QFETCH(QByteArray, answer);
+
+    if (libscrypt_set_kernel(kernel) != 0) {
+        QSKIP("kernel not supported by this cpu");
+    }
+    QCOMPARE(libscrypt_get_kernel(), kernel);
+    QCOMPARE(scrypt(password, salt, N, r, p, size_t(answer.size())).toHex(), answer.toHex());
+}
+
+void tst_Scrypt::testScryptKernelsEqual_data() {
+    QTest::addColumn<int>("kernel");
+    QTest::addColumn<quint64>("N");
+    QTest::addColumn<quint32>("r");
+    QTest::addColumn<quint32>("p");
+
+    // Odd p makes the two-lane kernel finish on its single-block path
+    for (int kernel: {LIBSCRYPT_KERNEL_SSE2, LIBSCRYPT_KERNEL_AVX2}) {
+        const QByteArray name = libscrypt_kernel_name(kernel);
+        QTest::newRow(("p1 " + name).constData()) << kernel << quint64(64) << quint32(1) << quint32(1);
+        QTest::newRow(("p2 " + name).constData()) << kernel << quint64(128) << quint32(2) << quint32(2);
+        QTest::newRow(("p3 " + name).constData()) << kernel << quint64(256) << quint32(3) << quint32(3);
+        QTest::newRow(("p8 " + name).constData()) << kernel << quint64(1024) << quint32(8) << quint32(8);
+    }
+}
+
+void tst_Scrypt::testScryptKernelsEqual() {
+    QFETCH(int, kernel);
+    QFETCH(quint64, N);
+    QFETCH(quint32, r);
+    QFETCH(quint32, p);
+
+    if (!libscrypt_kernel_supported(kernel)) {
+        QSKIP("kernel not supported by this cpu");
+    }
+
+    const QByteArray password = "correct horse battery staple";
+    const QByteArray salt = QByteArray::fromHex("aae8b7784e281077fac0f54b7bd661ab");
+
+    QCOMPARE(libscrypt_set_kernel(LIBSCRYPT_KERNEL_NOSSE), 0);
+    const QByteArray reference = scrypt(password, salt, N, r, p, 64);
+    QCOMPARE(libscrypt_set_kernel(kernel), 0);
+    const QByteArray result = scrypt(password, salt, N, r, p, 64);
+
+    QVERIFY(!reference.isEmpty());
+    QCOMPARE(result.toHex(), reference.toHex());
+}
+
+void tst_Scrypt::testScryptThreads_data() {
+    QTest::addColumn<quint32>("threads");
+
+    QTest::newRow("threads 1") << quint32(1);
+    QTest::newRow("threads 2") << quint32(2);
+    QTest::newRow("threads 3") << quint32(3);
+    QTest::newRow("threads 16") << quint32(16);
+    QTest::newRow("threads default") << quint32(0);
+}
+
+void tst_Scrypt::testScryptThreads() {
+    QFETCH(quint32, threads);
+
+    libscrypt_set_max_threads(threads);
+    QCOMPARE(scrypt("password", "NaCl", 1024, 8, 16, 64).toHex(), QByteArray("fdbabe1c9d3472007856e7190d01e9fe7c6ad7cbc8237830e77376634b3731622eaf30d92e22a3886ff109279d9830dac727afb94a83ee6d8360cbdfa2cc0640"));
+}
+
+void tst_Scrypt::benchmarkScryptBip38_data() {
+    QTest::addColumn<int>("kernel");
+    QTest::addColumn<quint32>("threads");
+
+    for (int kernel: {LIBSCRYPT_KERNEL_NOSSE, LIBSCRYPT_KERNEL_SSE2, LIBSCRYPT_KERNEL_AVX2}) {
+        const QByteArray name = libscrypt_kernel_name(kernel);
+        QTest::newRow((name + " single thread").constData()) << kernel << quint32(1);
+        QTest::newRow((name + " all threads").constData()) << kernel << quint32(0);
+    }
+}
+
+void tst_Scrypt::benchmarkScryptBip38() {
+    QFETCH(int, kernel);
+    QFETCH(quint32, threads);
+
+    if (libscrypt_set_kernel(kernel) != 0) {
+        QSKIP("kernel not supported by this cpu");
+    }
+    libscrypt_set_max_threads(threads);
+
+    // Parameters of encryptWif/decryptWif (btctx/wif.cpp)
+    QByteArray result;
+    QBENCHMARK {
+        result = scrypt("TestingOneTwoThree", QByteArray::fromHex("e957a24a"), 16384, 8, 8, 64);
+    }
+    QCOMPARE(result.size(), 64);
+}
+
+QTEST_MAIN(tst_Scrypt)
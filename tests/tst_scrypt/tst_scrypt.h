@@ -0,0 +1,32 @@
+#ifndef TST_SCRYPT_H
+#define TST_SCRYPT_H
+
+#include <QObject>
+#include <QTest>
+
+
+class tst_Scrypt : public QObject
+{
+    Q_OBJECT
+public:
+    explicit tst_Scrypt(QObject *parent = nullptr);
+
+private slots:
+
+    void cleanup();
+
+    void testScryptVectors_data();
+    void testScryptVectors();
+
+    void testScryptKernelsEqual_data();
+    void testScryptKernelsEqual();
+
+    void testScryptThreads_data();
+    void testScryptThreads();
+
+    void benchmarkScryptBip38_data();
+    void benchmarkScryptBip38();
+
+};
+
+#endif // TST_SCRYPT_H
@@ -0,0 +1,23 @@
+QT       += testlib
+QT       -= gui
+TARGET = tst_scrypt
+CONFIG   += testcase
+CONFIG += c++14
+CONFIG += static
+
+TEMPLATE = app
+
+INCLUDEPATH = ../../src
+
+SOURCES += \
+    tst_scrypt.cpp \
+    ../../src/ethtx/scrypt/crypto_scrypt-nosse.cpp \
+    ../../src/ethtx/scrypt/crypto_scrypt-sse.cpp \
+    ../../src/ethtx/scrypt/crypto_scrypt_smix.cpp \
+    ../../src/ethtx/scrypt/sha256.cpp \
+    ../../src/ThreadPool.cpp
+
+HEADERS += \
+    tst_scrypt.h
+
+QMAKE_LFLAGS += -rdynamic
@@ -4,16 +4,25 @@
 
 #include <iostream>
 
+#include <cryptopp/osrng.h>
+#include <cryptopp/oids.h>
+#include <cryptopp/dsa.h>
+#include <cryptopp/hex.h>
+
 #include "btctx/wif.h"
 #include "Wallet.h"
 #include "EthWallet.h"
 #include "BtcWallet.h"
 #include "utils.h"
 #include "openssl_wrapper/openssl_wrapper.h"
+#include "KeySessions.h"
+#include "Codecs.h"
+#include "ethtx/utils2.h"
 
 #include "check.h"
 
 Q_DECLARE_METATYPE(std::string)
+Q_DECLARE_METATYPE(CodecsKernel)
 
 
 tst_Wallet::tst_Wallet(QObject *parent)
@@ -167,6 +176,155 @@ void tst_Wallet::testMthSignTransaction() {
     QCOMPARE(res2, false);
 }
 
+void tst_Wallet::testMthSignBatch() {
+    std::string tmp;
+    std::string address;
+    Wallet::createWallet("./", "123", tmp, address);
+    const Wallet wallet("./", address, "123");
+
+    std::vector<Wallet::TxParams> txs;
+    for (uint64_t i = 0; i < 50; i++) {
+        Wallet::TxParams tx;
+        tx.toAddress = "0x009806da73b1589f38630649bdee48467946d118059efd6aab";
+        tx.value = 1000 + i;
+        tx.fee = i % 3;
+        tx.nonce = i + 1;
+        tx.dataHex = i % 2 == 0 ? "" : "0102";
+        txs.emplace_back(tx);
+    }
+
+    std::string pubkey;
+    const std::vector<Wallet::SignedTx> result = wallet.signBatch(txs, pubkey);
+    QCOMPARE(result.size(), txs.size());
+    for (size_t i = 0; i < txs.size(); i++) {
+        const std::string txBinary = Wallet::genTx(txs[i].toAddress, txs[i].value, txs[i].fee, txs[i].nonce, txs[i].dataHex);
+        QCOMPARE(result[i].txHex, toHex(txBinary));
+        QCOMPARE(Wallet::verify(txBinary, result[i].signature, pubkey), true);
+    }
+
+    std::string pubkey2;
+    const std::vector<Wallet::SignedTx> result2 = wallet.signBatch(txs, pubkey2, 1);
+    QCOMPARE(pubkey2, pubkey);
+    QCOMPARE(result2.size(), txs.size());
+
+    txs[25].toAddress = "0x009806da73b1589f38630649bdee48467946d118059efd6aa";
+    QVERIFY_EXCEPTION_THROWN(wallet.signBatch(txs, pubkey), TypedException);
+}
+
+void tst_Wallet::testMthVerifyBatch() {
+    std::string tmp;
+    std::string address;
+    Wallet::createWallet("./", "123", tmp, address);
+    Wallet wallet("./", address, "123");
+    std::string address2;
+    Wallet::createWallet("./", "123", tmp, address2);
+    Wallet wallet2("./", address2, "123");
+
+    std::vector<Wallet::VerifyParams> items;
+    std::vector<bool> answer;
+    for (size_t i = 0; i < 40; i++) {
+        Wallet::VerifyParams item;
+        item.message = "message " + std::to_string(i);
+        item.signature = (i % 2 == 0 ? wallet : wallet2).sign(item.message, item.publicKey);
+        items.emplace_back(item);
+        answer.emplace_back(true);
+    }
+    items[3].message += " ";
+    answer[3] = false;
+    items[4].publicKey = items[5].publicKey;
+    answer[4] = false;
+    items[6].signature = items[6].signature.substr(0, 10);
+    answer[6] = false;
+    items[7].publicKey = "0102";
+    answer[7] = false;
+
+    QCOMPARE(Wallet::verifyBatch(items), answer);
+    QCOMPARE(Wallet::verifyBatch(items, 1), answer);
+    for (size_t i = 0; i < items.size(); i++) {
+        QCOMPARE(Wallet::verify(items[i].message, items[i].signature, items[i].publicKey), bool(answer[i]));
+    }
+}
+
+void tst_Wallet::testSignSecp256r1_data() {
+    QTest::addColumn<std::string>("message");
+    QTest::addColumn<std::string>("answer");
+
+    // RFC 6979, A.2.5, SHA-256
+    QTest::newRow("SignSecp256r1 sample")
+        << std::string("sample")
+        << std::string("efd48b2aacb6a8fd1140dd9cd45e81d69d2c877b56aaf991c34d0ea84eaf3716f7cb1c942d657c41d436c7a1b6e29f65f3e900dbb9aff4064dc4ab2f843acda8");
+
+    QTest::newRow("SignSecp256r1 test")
+        << std::string("test")
+        << std::string("f1abb023518351cd71d881567b1ea663ed3efcf6c5132b354f28d3b0b7d38367019f4113742a2b14bd25926b49c649155f267e60d3814b4c0cc84250e46f0083");
+}
+
+void tst_Wallet::testSignSecp256r1() {
+    QFETCH(std::string, message);
+    QFETCH(std::string, answer);
+
+    const std::string privateKeyBinary = fromHex("c9afa9d845ba75166b5c215767b1d6934e50c3db36e89b127b8a622b120f6721");
+    std::array<unsigned char, 32> privateKey;
+    std::copy(privateKeyBinary.begin(), privateKeyBinary.end(), privateKey.begin());
+
+    const std::string result = toHex(signSecp256r1(privateKey, message));
+    QCOMPARE(result, answer);
+}
+
+void tst_Wallet::testMthSignBenchmark_data() {
+    QTest::addColumn<bool>("isCryptopp");
+
+    QTest::newRow("MthSign cryptopp") << true;
+    QTest::newRow("MthSign wallet") << false;
+}
+
+void tst_Wallet::testMthSignBenchmark() {
+    QFETCH(bool, isCryptopp);
+
+    std::string tmp;
+    std::string address;
+    Wallet::createWallet("./", "123", tmp, address);
+    Wallet wallet("./", address, "123");
+    const std::string txBinary = Wallet::genTx("0x009806da73b1589f38630649bdee48467946d118059efd6aab", 126894, 55647, 255, "");
+
+    if (isCryptopp) {
+        // Прежняя реализация Wallet::sign
+        const SecureBytes exponent = wallet.getPrivateExponent();
+        CryptoPP::ECDSA<CryptoPP::ECP, CryptoPP::SHA256>::PrivateKey privateKey;
+        privateKey.Initialize(CryptoPP::ASN1::secp256r1(), CryptoPP::Integer(exponent.data(), exponent.size()));
+        QBENCHMARK {
+            CryptoPP::AutoSeededRandomPool prng;
+            CryptoPP::ECDSA<CryptoPP::ECP, CryptoPP::SHA256>::Signer signer(privateKey);
+            std::string signature(signer.MaxSignatureLength(), 0);
+            const size_t siglen = signer.SignMessage(prng, (const byte*)txBinary.data(), txBinary.size(), (byte*)signature.data());
+            signature.resize(siglen);
+            std::string signature2(signature.size() * 10, 0);
+            signature2.resize(CryptoPP::DSAConvertSignatureFormat(
+                (byte*)signature2.data(), signature2.size(), CryptoPP::DSASignatureFormat::DSA_DER,
+                (const byte*)signature.data(), signature.size(), CryptoPP::DSASignatureFormat::DSA_P1363
+            ));
+            std::string publicKey;
+            CryptoPP::ECDSA<CryptoPP::ECP, CryptoPP::SHA256>::PublicKey publicK;
+            privateKey.MakePublicKey(publicK);
+            publicK.AccessGroupParameters().SetEncodeAsOID(true);
+            CryptoPP::HexEncoder encoder(new CryptoPP::StringSink(publicKey), true);
+            publicK.DEREncode(encoder);
+            encoder.MessageEnd();
+        }
+    } else {
+        QBENCHMARK {
+            std::string publicKey;
+            wallet.sign(txBinary, publicKey);
+        }
+    }
+
+    std::string publicKey;
+    const std::string signature = wallet.sign(txBinary, publicKey);
+    QCOMPARE(Wallet::verify(txBinary, signature, publicKey), true);
+    std::string publicKey2;
+    QCOMPARE(wallet.sign(txBinary, publicKey2), signature);
+}
+
 void tst_Wallet::testHashMth_data() {
     QTest::addColumn<std::string>("transaction");
     QTest::addColumn<std::string>("answer");
@@ -588,6 +746,51 @@ void tst_Wallet::testEthWalletTransaction()
     QCOMPARE(result, std::string("0xf899018506c088e200828208948d78b1ab426dc9daa7427b7a60e64633f62e645f85746a528800b001010101010101010101010101010101010101010101010101010101010101010101010101010101010101010101010126a047dd9f6ebce749230df9ac9d57db85f948db0775882cb63565501fe95ddfcb58a07c7020426395bc781fc06e4fbb5cffc5c4d8b77d37596b1c83fa0c21ce37cfb3"));
 }
 
+void tst_Wallet::testKeySessions() {
+    KeySessions sessions;
+    SecureBytes secret;
+
+    std::string tmp;
+    std::string address;
+    Wallet::createWallet("./", "123", tmp, address);
+    Wallet wallet("./", address, "123");
+    sessions.open("./", address, "123", wallet.getPrivateExponent(), 10s, 2);
+
+    QCOMPARE(sessions.use("./", address, "1234", secret), false);
+    QCOMPARE(sessions.use("./other", address, "123", secret), false);
+    QCOMPARE(sessions.use("./", address, "123", secret), true);
+    Wallet sessionWallet("./", address, secret);
+    std::string pubkey;
+    const std::string signature = sessionWallet.sign("message", pubkey);
+    std::string pubkey2;
+    wallet.sign("message", pubkey2);
+    QCOMPARE(pubkey, pubkey2);
+    QCOMPARE(Wallet::verify("message", signature, pubkey2), true);
+
+    QCOMPARE(sessions.use("./", address, "123", secret), true);
+    QCOMPARE(sessions.use("./", address, "123", secret), false);
+    QCOMPARE(sessions.size(), size_t(0));
+
+    writeToFile("./0x05cf594f12bba9430e34060498860abc69554cb1", "{\"address\": \"05cf594f12bba9430e34060498860abc69554cb1\",\"crypto\": {\"cipher\": \"aes-128-ctr\",\"ciphertext\": \"694283a4a2f3da99186e2321c24cf1b427d81a273e7bc5c5a54ab624c8930fb8\",\"cipherparams\": {\"iv\": \"5913da2f0f6cd00b9b62ff2bc0a8b9d3\"},\"kdf\": \"scrypt\",\"kdfparams\": {\"dklen\": 32,\"n\": 262144,\"p\": 1,\"r\": 8,\"salt\": \"ca45d433267bd6a50ace149d6b317b9d8f8a39f43621bad2a3108981bf533ee7\"},\"mac\": \"0a8d581e8c60553970301603ea35b0fc56cbccd5913b12f62c690acb98d111c8\"},\"id\": \"6406896a-2ec9-4dd7-b98e-5fbfc0984e6f\",\"version\": 3}", false);
+    const std::string ethAddress = "0x05cf594f12bba9430e34060498860abc69554cb1";
+    const EthWallet ethWallet("./", ethAddress, "1");
+    sessions.open("./", ethAddress, "1", ethWallet.getRawPrivateKey(), 10s, 10);
+    QCOMPARE(sessions.use("./", ethAddress, "1", secret), true);
+    EthWallet ethSessionWallet(ethAddress, secret);
+    const std::string result = ethSessionWallet.SignTransaction(
+        "0x01",
+        "0x6C088E200",
+        "0x8208",
+        "0x8D78B1Ab426dc9daa7427b7A60E64633f62E645F",
+        "0x746A528800",
+        "0x010101010101010101010101010101010101010101010101010101010101010101010101010101010101010101010101"
+    );
+    QCOMPARE(result, std::string("0xf899018506c088e200828208948d78b1ab426dc9daa7427b7a60e64633f62e645f85746a528800b001010101010101010101010101010101010101010101010101010101010101010101010101010101010101010101010126a047dd9f6ebce749230df9ac9d57db85f948db0775882cb63565501fe95ddfcb58a07c7020426395bc781fc06e4fbb5cffc5c4d8b77d37596b1c83fa0c21ce37cfb3"));
+
+    QCOMPARE(sessions.close("./", ethAddress), true);
+    QCOMPARE(sessions.use("./", ethAddress, "1", secret), false);
+}
+
 void tst_Wallet::testNotCreateEthTransaction_data() {
     QTest::addColumn<std::string>("to");
     QTest::addColumn<std::string>("nonce");
@@ -718,4 +921,187 @@ void tst_Wallet::testSsl() {
     QCOMPARE(decryptMsg, message);
 }
 
+//////////////
+/// CODECS ///
+//////////////
+
+static std::string makeCodecsData(size_t size) {
+    std::string result(size, 0);
+    uint32_t state = static_cast<uint32_t>(size) + 1;
+    for (char &c: result) {
+        state = state * 1103515245 + 12345;
+        c = static_cast<char>(state >> 16);
+    }
+    return result;
+}
+
+static void addCodecsKernelRows(const std::vector<size_t> &sizes) {
+    for (CodecsKernel kernel: {CodecsKernel::Scalar, CodecsKernel::Ssse3, CodecsKernel::Avx2}) {
+        for (size_t size: sizes) {
+            QTest::newRow((QByteArray(codecsKernelName(kernel)) + " " + QByteArray::number(qulonglong(size))).constData()) << kernel << size;
+        }
+    }
+}
+
+void tst_Wallet::cleanup() {
+    setCodecsKernel(CodecsKernel::Auto);
+}
+
+void tst_Wallet::testCodecs_data() {
+    QTest::addColumn<CodecsKernel>("kernel");
+    QTest::addColumn<size_t>("size");
+
+    // Границы векторных блоков: 12/16/24/32 байта на кодирование, 16/32/64 символа на декодирование
+    addCodecsKernelRows({0, 1, 2, 3, 4, 11, 12, 15, 16, 17, 23, 24, 28, 31, 32, 33, 47, 48, 63, 64, 65, 100, 1000, 4099});
+}
+
+void tst_Wallet::testCodecs() {
+    QFETCH(CodecsKernel, kernel);
+    QFETCH(size_t, size);
+
+    if (!setCodecsKernel(kernel)) {
+        QSKIP("kernel not supported by this cpu");
+    }
+    QCOMPARE(getCodecsKernel(), kernel);
+
+    const std::string data = makeCodecsData(size);
+    const QByteArray array(data.data(), data.size());
+
+    const std::string hex = toHex(data);
+    QCOMPARE(hex, QString(array.toHex()).toStdString());
+    QCOMPARE(fromHex(hex), data);
+    QCOMPARE(fromHex(QString::fromStdString(hex).toUpper().toStdString()), data);
+    QCOMPARE(HexStringToDump(hex), data);
+    QCOMPARE(DumpToHexString(data), hex);
+
+    const std::string base64 = toBase64(data);
+    QCOMPARE(base64, QString(array.toBase64()).toStdString());
+    QCOMPARE(fromBase64(base64), data);
+
+    // RFC 4648
+    QCOMPARE(toBase64("foobar"), std::string("Zm9vYmFy"));
+    QCOMPARE(toBase64("fooba"), std::string("Zm9vYmE="));
+    QCOMPARE(toBase64("foob"), std::string("Zm9vYg=="));
+    QCOMPARE(fromBase64("Zm9vYg=="), std::string("foob"));
+    QCOMPARE(fromBase64("Zm9vYmE="), std::string("fooba"));
+}
+
+void tst_Wallet::testCodecsInvalid_data() {
+    QTest::addColumn<CodecsKernel>("kernel");
+    QTest::addColumn<size_t>("size");
+
+    addCodecsKernelRows({48, 200});
+}
+
+void tst_Wallet::testCodecsInvalid() {
+    QFETCH(CodecsKernel, kernel);
+    QFETCH(size_t, size);
+
+    if (!setCodecsKernel(kernel)) {
+        QSKIP("kernel not supported by this cpu");
+    }
+
+    const std::string data = makeCodecsData(size);
+    const std::string hex = toHex(data);
+    const std::string base64 = toBase64(data);
+    std::string out(size, 0);
+
+    for (const char bad: {'g', 'G', ':', '@', '`', ' ', '\x80', '\xff'}) {
+        for (size_t i = 0; i < hex.size(); i++) {
+            std::string broken = hex;
+            broken[i] = bad;
+            QCOMPARE(decodeHex(broken.data(), broken.size(), &out[0]), false);
+            QVERIFY_EXCEPTION_THROWN(HexStringToDump(broken), Exception);
+        }
+    }
+    QCOMPARE(decodeHex(hex.data(), hex.size() - 1, &out[0]), false);
+
+    for (const char bad: {'-', '_', '.', ':', '=', '\n', '\x80', '\xff'}) {
+        // '=' в последних позициях - допустимое выравнивание
+        const size_t end = bad == '=' ? base64.size() - 2 : base64.size();
+        for (size_t i = 0; i < end; i++) {
+            std::string broken = base64;
+            broken[i] = bad;
+            QCOMPARE(decodeBase64(broken.data(), broken.size(), &out[0]), false);
+        }
+    }
+    QCOMPARE(decodeBase64(base64.data(), base64.size() - 1, &out[0]), false);
+
+    // Нестрогий ввод разбирается как раньше через Qt
+    const QByteArray array(data.data(), data.size());
+    const std::string base64Lines = QString(array.toBase64()).insert(16, '\n').toStdString();
+    QCOMPARE(fromBase64(base64Lines), data);
+    QCOMPARE(fromHex("0x" + hex), QByteArray::fromHex(QByteArray::fromStdString("0x" + hex)).toStdString());
+    QCOMPARE(fromHex(hex.substr(1)), QByteArray::fromHex(QByteArray::fromStdString(hex.substr(1))).toStdString());
+    QCOMPARE(HexStringToDump(hex.substr(1)), QByteArray::fromHex(QByteArray::fromStdString(hex.substr(1))).toStdString());
+}
+
+void tst_Wallet::testCodecsBenchmark_data() {
+    QTest::addColumn<QString>("operation");
+    QTest::addColumn<bool>("isQt");
+
+    for (const QString &operation: {"toHex", "fromHex", "toBase64", "fromBase64"}) {
+        QTest::newRow((operation + " qt").toLatin1().constData()) << operation << true;
+        QTest::newRow((operation + " codecs").toLatin1().constData()) << operation << false;
+    }
+}
+
+void tst_Wallet::testCodecsBenchmark() {
+    QFETCH(QString, operation);
+    QFETCH(bool, isQt);
+
+    // Порядок поля data у ERC-20 транзакций и загружаемых файлов
+    const std::string data = makeCodecsData(4 * 1024 * 1024);
+    const std::string hex = toHex(data);
+    const std::string base64 = toBase64(data);
+
+    std::string result;
+    // Прежняя реализация utils.cpp
+    if (operation == "toHex") {
+        if (isQt) {
+            QBENCHMARK {
+                result = QString(QByteArray(data.data(), data.size()).toHex()).toStdString();
+            }
+        } else {
+            QBENCHMARK {
+                result = toHex(data);
+            }
+        }
+        QCOMPARE(result, hex);
+    } else if (operation == "fromHex") {
+        if (isQt) {
+            QBENCHMARK {
+                result = QByteArray::fromHex(QByteArray(hex.data(), hex.size())).toStdString();
+            }
+        } else {
+            QBENCHMARK {
+                result = fromHex(hex);
+            }
+        }
+        QCOMPARE(result, data);
+    } else if (operation == "toBase64") {
+        if (isQt) {
+            QBENCHMARK {
+                result = QString(QByteArray(data.data(), data.size()).toBase64()).toStdString();
+            }
+        } else {
+            QBENCHMARK {
+                result = toBase64(data);
+            }
+        }
+        QCOMPARE(result, base64);
+    } else {
+        if (isQt) {
+            QBENCHMARK {
+                result = QByteArray::fromBase64(QByteArray(base64.data(), base64.size())).toStdString();
+            }
+        } else {
+            QBENCHMARK {
+                result = fromBase64(base64);
+            }
+        }
+        QCOMPARE(result, data);
+    }
+}
+
 QTEST_MAIN(tst_Wallet)
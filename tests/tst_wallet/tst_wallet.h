@@ -45,6 +45,16 @@ private slots:
     void testMthSignTransaction_data();
     void testMthSignTransaction();
 
+    void testMthSignBatch();
+
+    void testMthVerifyBatch();
+
+    void testSignSecp256r1_data();
+    void testSignSecp256r1();
+
+    void testMthSignBenchmark_data();
+    void testMthSignBenchmark();
+
     void testCreateEth_data();
     void testCreateEth();
     
@@ -53,6 +63,8 @@ private slots:
 
     void testEthWalletTransaction();
 
+    void testKeySessions();
+
     void testNotCreateEthTransaction_data();
     void testNotCreateEthTransaction();
 
@@ -65,6 +77,17 @@ private slots:
     void testNotCreateBtcTransaction2_data();
     void testNotCreateBtcTransaction2();
 
+    void testCodecs_data();
+    void testCodecs();
+
+    void testCodecsInvalid_data();
+    void testCodecsInvalid();
+
+    void testCodecsBenchmark_data();
+    void testCodecsBenchmark();
+
+    void cleanup();
+
 };
 
 #endif // TST_WALLET_H
@@ -16,6 +16,8 @@ SOURCES += \
     ../../src/machine_uid_win.cpp \
     ../../src/EthWallet.cpp \
     ../../src/ethtx/scrypt/crypto_scrypt-nosse.cpp \
+    ../../src/ethtx/scrypt/crypto_scrypt-sse.cpp \
+    ../../src/ethtx/scrypt/crypto_scrypt_smix.cpp \
     ../../src/ethtx/scrypt/sha256.cpp \
     ../../src/ethtx/cert.cpp \
     ../../src/ethtx/rlp.cpp \
@@ -32,7 +34,12 @@ SOURCES += \
     ../../src/utils.cpp \
     ../../src/ethtx/utils2.cpp \
     ../../src/Log.cpp \
-    ../../src/Paths.cpp
+    ../../src/LogRotation.cpp \
+    ../../src/Paths.cpp \
+    ../../src/ThreadPool.cpp \
+    ../../src/SecureMemory.cpp \
+    ../../src/KeySessions.cpp \
+    ../../src/Codecs.cpp
 
 HEADERS += \
     tst_wallet.h